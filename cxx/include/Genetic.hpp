@@ -3,28 +3,240 @@
 
 #include "Utility.hpp"
 #include "Kokkos_Random.hpp"
-#include "Kokkos_Sort.hpp"
-#include "Kokkos_StdAlgorithms.hpp"
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <future>
+#include <limits>
+#include <memory>
 #include <random>
 
+// How parents are chosen for breeding
+enum SelectionMethod {
+  ROULETTE_SELECTION,   // Proportional to rating - lowest rating
+  TOURNAMENT_SELECTION, // Best of tournament_size random members
+  UNIVERSAL_SELECTION,  // Stochastic universal sampling of the roulette wheel
+  PARETO_SELECTION      // NSGA-II: tournaments by non-dominated front, then crowding distance, over the
+                        // runner's objectives; the rating only picks the best member
+};
+
+// How a child combines the genes of its parents
+enum CrossoverMethod {
+  PMX_CROSSOVER,   // Mom's segment, and dad's genes mapped through it for the rest
+  ORDER_CROSSOVER, // Mom's segment, and the rest of the genes in the order dad has them
+  CYCLE_CROSSOVER  // Alternate whole cycles of the two parents, so every gene keeps one parent's cell
+};
+
+// What happens to a member whose genes match another member's when the population is rated
+enum DeduplicationMethod {
+  KEEP_DUPLICATES,    // Every member is rated, repeats included
+  MEMOIZE_DUPLICATES, // Repeats copy the rating, rating state and repair of the member they match
+  REPLACE_DUPLICATES  // Repeats are replaced by random members, which keeps the population diverse
+};
+
+// Why run() stopped early
+enum StopReason {
+  NOT_STOPPED,
+  TARGET_REACHED, // The best rating reached the target
+  STAGNATED,      // The best rating stopped improving, even with the mutation rate escalated
+  CONVERGED,      // The ratings are all within the diversity threshold of each other
+  OUT_OF_TIME     // The wall-clock budget ran out
+};
+
+// Progress of a run, tracked on the device after every generation
+struct Convergence {
+  double best_rating;
+  unsigned stagnant_generations;
+  double mutation_scale;
+  unsigned reason;
+};
+
+// The stages of a generation, each wrapped in a Kokkos Profiling region
+enum ProfileStage {
+  REPAIR_STAGE,
+  RATE_STAGE,
+  SORT_STAGE,
+  WEIGHTS_STAGE,
+  BREED_STAGE,
+  MUTATE_STAGE,
+  SEARCH_STAGE,
+  RECORD_STAGE,
+  CHECKPOINT_STAGE,
+  NSTAGES
+};
+
+// Work done by the kernels, counted on the device while profiling
+struct ProfileCounters {
+  unsigned long long full_ratings;
+  unsigned long long delta_ratings;
+  unsigned long long mutations;
+  unsigned long long repair_steps; // PMX lookups of genes already inherited from the mom
+  unsigned long long local_swaps;  // Swaps kept by the local search
+  unsigned long long duplicates;   // Members whose genes matched another member's
+  unsigned long long repairs;      // Members repaired by the runner before being rated from scratch
+};
+
+// The bin holding the worst elite while sort narrows it down
+struct EliteCutoff {
+  unsigned bin;
+  unsigned nabove;        // members above the bin, which are all elite
+  unsigned ncandidates;   // members of the bin
+  unsigned needed;        // how many of them are elite
+  unsigned best_position; // where the best member is among them, if it is one
+};
+
+// Where the time of one generation went
+struct GenerationProfile {
+  unsigned generation;
+  double seconds[NSTAGES];
+  ProfileCounters counters;
+};
+
+// Layout of a checkpoint file
+// The header is followed by the convergence state, the ratings, the population in row-major order,
+// the rating states and the mutation operator probabilities and qualities, each starting on an 8 byte
+// boundary so the file can be mapped straight into memory
+struct CheckpointHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t generation;
+  uint64_t seed;
+  uint32_t popSize;
+  uint32_t member_size;
+  uint32_t state_size;
+  uint32_t gene_size;
+};
+
 template<class Runner>
 class Genetic {
 public:
+  // Runners pick the narrowest type that can index their genes to save memory bandwidth
+  typedef typename Runner::ViewType::non_const_value_type GeneType;
+
   Genetic(Runner& runner);
   auto run(unsigned popSize, unsigned eliteSize, double mutationRate, unsigned generations);
+  void set_delta_rating(bool delta_rating);
+  void set_team_parallelism(bool team_parallelism);
+  void set_selection(SelectionMethod selection, unsigned tournament_size=2);
+  void set_crossover(CrossoverMethod crossover);
+  void set_greedy_seeds(unsigned greedy_seeds);
+  void set_report_interval(unsigned report_interval);
+  void set_execution_space(const Kokkos::DefaultExecutionSpace& exec);
+  void set_seed(unsigned seed);
+  void set_checkpoint(const std::string& filename, unsigned checkpoint_interval);
+  void set_restart(const std::string& filename);
+  void set_profile(const std::string& filename, unsigned profile_interval);
+  // Stopping criteria, which are off by default
+  void set_target_rating(double target_rating);
+  void set_stagnation_limit(unsigned stagnation_limit);
+  void set_time_limit(double seconds);
+  void set_diversity_threshold(double diversity_threshold);
+  void set_mutation_escalation(double factor, double max_scale);
+  void set_local_search(unsigned nmembers, unsigned max_steps);
+  void set_deduplication(DeduplicationMethod deduplication);
+  void set_repair_interval(unsigned repair_interval);
+  void set_full_rating_interval(unsigned full_rating_interval);
+
+  // run() is built from these, and a caller can use them to step through the generations itself
+  void initialize(unsigned popSize);
+  void rank_population(unsigned eliteSize);
+  void next_generation(unsigned eliteSize, double mutationRate);
+  auto pull_best();
+  double best_rating() const;
+  // The objectives of every member, smaller being better, and with PARETO_SELECTION the front of every
+  // member, 0 being the non-dominated one; both are only valid after rank_population
+  auto pull_objectives();
+  auto pull_fronts();
+  auto pull_member(unsigned i);
+  unsigned member_size() const;
+  // Migrants are stored one flattened member per row
+  void get_migrants(Kokkos::View<GeneType**> members, Kokkos::View<double*> ratings) const;
+  void add_migrants(Kokkos::View<GeneType**> members, Kokkos::View<double*> ratings, unsigned eliteSize);
 
   // These items should be private but have to be public because #GPUs
   void rate_population();
   void compute_weights();
   void breed_population(unsigned eliteSize);
   void mutate_population(double mutationRate);
+  void rate_population_team();
+  void find_duplicates();
+  void copy_duplicates();
+  void repair_population();
+  void breed_population_team(unsigned eliteSize);
+  void local_search(unsigned eliteSize);
+  void adapt_mutation_operators();
 private:
-  void sort();
-  auto get_best_member();
+  typedef Kokkos::TeamPolicy<>::member_type TeamMember;
+  typedef Kokkos::DefaultExecutionSpace::scratch_memory_space ScratchSpace;
+  typedef Kokkos::View<GeneType*, ScratchSpace, Kokkos::MemoryUnmanaged> ScratchView1D;
+  typedef Kokkos::View<GeneType**, ScratchSpace, Kokkos::MemoryUnmanaged> ScratchView2D;
+  typedef Kokkos::RangePolicy<Kokkos::DefaultExecutionSpace, Kokkos::IndexType<unsigned>> RangePolicy;
+  typedef std::conditional_t<Runner::ViewType::rank == 2, Kokkos::View<GeneType*>, Kokkos::View<GeneType**>> MemberView;
+
+  void sort(unsigned eliteSize);
+  void find_cutoff();
+  void narrow_cutoff();
+  void cutoff_bounds();
+  void rank_fronts();
   KOKKOS_INLINE_FUNCTION auto get_population_member(unsigned i, bool current=true) const;
+  KOKKOS_INLINE_FUNCTION auto get_member_positions(unsigned i, bool current=true) const;
+  KOKKOS_INLINE_FUNCTION void index_member(unsigned i, bool current=true) const;
+  KOKKOS_INLINE_FUNCTION void randomize_member(unsigned i) const;
   void make_initial_population(unsigned popSize);
-  KOKKOS_INLINE_FUNCTION unsigned get_parent() const;
+  KOKKOS_INLINE_FUNCTION unsigned get_parent(unsigned draw=unsigned(-1)) const;
   KOKKOS_INLINE_FUNCTION void breed(unsigned mom_index, unsigned dad_index, unsigned child_index) const;
+  KOKKOS_INLINE_FUNCTION void breed(const TeamMember& team, unsigned mom_index, unsigned dad_index, 
+                                    unsigned child_index) const;
+  KOKKOS_INLINE_FUNCTION Kokkos::pair<unsigned, unsigned> get_crossover_points(unsigned ngenes) const;
+  template<class MemberType, class PositionType>
+  KOKKOS_INLINE_FUNCTION GeneType pmx_gene(MemberType mom, MemberType dad, PositionType mom_positions,
+                                           unsigned cell, unsigned start_index, unsigned end_index,
+                                           unsigned& repair_steps) const;
+  template<class MemberType, class PositionType, class ChildType>
+  KOKKOS_INLINE_FUNCTION void order_crossover(MemberType mom, MemberType dad, PositionType mom_positions,
+                                              ChildType child, unsigned start_index, unsigned end_index) const;
+  template<class MemberType, class PositionType, class ChildType>
+  KOKKOS_INLINE_FUNCTION void cycle_crossover(MemberType mom, MemberType dad, PositionType mom_positions,
+                                              ChildType child) const;
+  KOKKOS_INLINE_FUNCTION void store_objectives(unsigned i) const;
+  KOKKOS_INLINE_FUNCTION void record_change(unsigned p, unsigned cell, unsigned old_value) const;
+  KOKKOS_INLINE_FUNCTION unsigned get_mutation_operator(double draw) const;
+  KOKKOS_INLINE_FUNCTION unsigned get_bin(unsigned i) const;
+  KOKKOS_INLINE_FUNCTION double get_cutoff_key(unsigned i) const;
+  KOKKOS_INLINE_FUNCTION unsigned get_cutoff_bin(unsigned i) const;
+  KOKKOS_INLINE_FUNCTION bool is_better(unsigned i, unsigned j) const;
+  void reseed(unsigned generation);
+  void update_convergence();
+  const char* stop_reason(unsigned reason) const;
+  void write_checkpoint(unsigned generation);
+  bool read_checkpoint(const std::string& filename, unsigned& generation);
+  KOKKOS_INLINE_FUNCTION void count_work(unsigned long long ProfileCounters::* counter, unsigned long long n) const;
+  void finish_profile();
+  void write_profile_summary() const;
+  static const char* stage_name(unsigned stage);
+
+  // Opens the profiling region of a stage, and adds the stage's time to the current profile
+  // when profiling; the timer waits for the stage's kernels, so it is only used then
+  class StageTimer {
+  public:
+    StageTimer(Genetic& genetic, ProfileStage stage);
+    ~StageTimer();
+  private:
+    Genetic& genetic_;
+    ProfileStage stage_;
+    Kokkos::Timer timer_;
+  };
+
+  typedef typename genetic::rating_state<Runner>::type RatingState;
+  static constexpr unsigned max_tracked_changes_{16};
+  static constexpr uint32_t checkpoint_version_{4};
+  static constexpr unsigned nmutation_operators_{genetic::mutation_operators<Runner>::value};
+  static constexpr unsigned nobjectives_{genetic::objectives<Runner>::value};
+  static constexpr double operator_adaptation_rate_{0.1};
+  static constexpr double min_operator_probability_{0.05};
+  // Checkpoints store the population row-major whatever the device layout is
+  typedef Kokkos::View<typename Runner::ViewType::data_type, Kokkos::LayoutRight> CheckpointView;
 
   Runner runner_;
   typename Runner::ViewType current_population_;
@@ -32,42 +244,399 @@ private:
   Kokkos::View<double*> ratings_;
   Kokkos::View<double*> weights_;
   Kokkos::View<unsigned*> permutation_;
+  // sort only separates out the elites, so the lowest and highest ratings live on the device
+  typedef Kokkos::MinMaxLocScalar<double, unsigned> RatingBounds;
+  Kokkos::View<RatingBounds> rating_bounds_;
+  Kokkos::View<unsigned*> bin_counts_;
+  // The members of the bin holding the worst elite are binned again, cutoff_rounds_ times, before they
+  // are ranked against each other
+  static constexpr unsigned cutoff_rounds_{3};
+  Kokkos::View<EliteCutoff> cutoff_;
+  Kokkos::View<unsigned*> cutoff_members_;
+  Kokkos::View<unsigned*> next_cutoff_members_;
+  Kokkos::View<Kokkos::MinMaxScalar<double>> cutoff_bounds_;
+  Kokkos::View<bool*> is_elite_;
+  // Every kernel is queued on exec_, and the host only waits on it every report_interval_ generations
+  Kokkos::DefaultExecutionSpace exec_;
+  unsigned report_interval_{100};
+  Kokkos::View<RatingBounds, Kokkos::SharedHostPinnedSpace> h_rating_bounds_;
+  MemberView best_member_;
+  typename MemberView::HostMirror h_best_member_;
+  // weights_ holds the cumulative roulette weights in permutation order
+  SelectionMethod selection_{ROULETTE_SELECTION};
+  unsigned tournament_size_{2};
+  CrossoverMethod crossover_{PMX_CROSSOVER};
+  unsigned greedy_seeds_{1};
+  unsigned npointers_{0};
+  double sus_offset_{0};
+  // Shuffles the pointers, so the moms and dads are not taken from opposite halves of the wheel
+  uint64_t sus_key_{0};
+  // The objectives of each member are written whenever it is rated, from its rating state
+  // With PARETO_SELECTION the elites are the first fronts, and the widest spread members of the front
+  // that does not fit; dominators_ has a bit for every member that dominates each member, and
+  // remaining_ a bit for every member that is not in a front yet
+  Kokkos::View<double**> objectives_;
+  Kokkos::View<unsigned*> fronts_;
+  Kokkos::View<double*> crowding_;
+  Kokkos::View<uint64_t**> dominators_;
+  Kokkos::View<uint64_t*> remaining_;
+  MemberView member_;
+  typename MemberView::HostMirror h_member_;
+  // Where each gene lives in its member, as a flattened (row,column) index for 2D members
+  // There are as many cells as genes, so the cell indices fit in a GeneType too
+  Kokkos::View<GeneType**> current_positions_;
+  Kokkos::View<GeneType**> next_positions_;
+  // Penalty terms of each member and the cells that changed since it was rated
+  // nchanges > max_tracked_changes_ means the member must be rated from scratch
+  bool delta_rating_{false};
+  bool team_parallelism_{false};
+  Kokkos::View<RatingState*> current_states_;
+  Kokkos::View<RatingState*> next_states_;
+  Kokkos::View<GeneType***> current_changes_;
+  Kokkos::View<GeneType***> next_changes_;
+  Kokkos::View<unsigned*> current_nchanges_;
+  Kokkos::View<unsigned*> next_nchanges_;
+  unsigned seed_{5374857}; // Declared before pool_, which is seeded with it
   std::default_random_engine rng_;
   Kokkos::Random_XorShift64_Pool<> pool_;
+  // A stagnant run first multiplies the mutation rate by mutation_escalation_, up to max_mutation_scale_,
+  // and only stops once that stops helping too
+  double target_rating_{std::numeric_limits<double>::infinity()};
+  unsigned stagnation_limit_{0};
+  double time_limit_{0};
+  double diversity_threshold_{0};
+  double mutation_escalation_{1};
+  double max_mutation_scale_{1};
+  // Runners with their own mutation operators pick one by how much it recently changed the elites' ratings
+  // The operator that mutated each elite (plus one) and its rating before are remembered until it is rated again
+  Kokkos::View<double*> operator_probabilities_;
+  Kokkos::View<double*> operator_qualities_;
+  Kokkos::View<double*[2]> operator_credits_; // uses and total rating change since the last adaptation
+  Kokkos::View<unsigned*> mutation_operators_;
+  Kokkos::View<double*> mutation_baselines_;
+  // The best local_search_members_ members hill-climb after every rating
+  unsigned local_search_members_{0};
+  unsigned local_search_steps_{0};
+  // Members are hashed by their genes every generation to find the repeats
+  DeduplicationMethod deduplication_{KEEP_DUPLICATES};
+  genetic::HashIndex genome_index_;
+  Kokkos::View<unsigned*> genome_slots_;
+  Kokkos::View<unsigned*> originals_; // the member whose rating each member copies, which is usually itself
+  // Members rated from scratch are repaired first, in generations that are a multiple of repair_interval_
+  unsigned repair_interval_{1};
+  // With delta rating, everyone is rated from scratch in generations that are a multiple of
+  // full_rating_interval_, so rounding error can't build up in the floating-point penalty terms
+  unsigned full_rating_interval_{100};
+  unsigned generation_{0};
+  Kokkos::View<Convergence> convergence_;
+  Kokkos::View<Convergence, Kokkos::SharedHostPinnedSpace> h_convergence_;
+  // Written straight from the device so the host can poll it every generation without a fence
+  Kokkos::View<unsigned, Kokkos::SharedHostPinnedSpace> h_stop_reason_;
+  // Checkpoints are staged on the host and written by checkpoint_writer_ while the run continues
+  std::string checkpoint_filename_;
+  unsigned checkpoint_interval_{0};
+  std::string restart_filename_;
+  // Kernels copy the whole class, so this has to be copyable
+  std::shared_ptr<std::future<void>> checkpoint_writer_;
+  CheckpointView checkpoint_population_;
+  typename CheckpointView::HostMirror h_checkpoint_population_;
+  typename Kokkos::View<double*>::HostMirror h_checkpoint_ratings_;
+  typename Kokkos::View<RatingState*>::HostMirror h_checkpoint_states_;
+  typename Kokkos::View<double*>::HostMirror h_checkpoint_probabilities_;
+  typename Kokkos::View<double*>::HostMirror h_checkpoint_qualities_;
+  // The profiles since the last multiple of profile_interval_ are kept in a buffer and summarized at the
+  // next one. A resumed run may start partway through, so only nprofiles_ of them are filled
+  std::string profile_filename_;
+  unsigned profile_interval_{0};
+  unsigned profile_generation_{0};
+  unsigned nprofiles_{0};
+  GenerationProfile current_profile_{};
+  Kokkos::View<GenerationProfile*, Kokkos::HostSpace> profiles_;
+  Kokkos::View<ProfileCounters> profile_counters_;
+  Kokkos::View<ProfileCounters, Kokkos::SharedHostPinnedSpace> h_profile_counters_;
 };
 
 template<class Runner>
-Genetic<Runner>::Genetic(Runner& runner) : runner_(runner), pool_(5374857) { }
+Genetic<Runner>::Genetic(Runner& runner) : runner_(runner), pool_(seed_) { }
 
 template<class Runner>
 auto Genetic<Runner>::run(unsigned popSize, unsigned eliteSize, double mutationRate, unsigned generations) {
+  Kokkos::Timer timer;
+  initialize(popSize);
+
+  // Pick up where a previous run left off
+  unsigned first_generation = 0;
+  bool resumed = !restart_filename_.empty() && read_checkpoint(restart_filename_, first_generation);
+  profile_generation_ = first_generation;
+  generation_ = first_generation;
+
+  // A run that stops early has already ranked and maybe reported its last generation
+  unsigned g;
+  bool ranked = false, reported = false;
+  for(g=first_generation; g<generations; g++) {
+    // The checkpoint was written after rating, so only the elites need to be found again
+    if(resumed && g == first_generation) {
+      sort(eliteSize);
+    }
+    else {
+      rank_population(eliteSize);
+      update_convergence();
+      if(checkpoint_interval_ > 0 && g % checkpoint_interval_ == 0) {
+        write_checkpoint(g);
+      }
+    }
+    ranked = true;
+
+    reported = g % report_interval_ == 0;
+    if(reported) {
+      StageTimer stage_timer(*this, RECORD_STAGE);
+      auto best_member = pull_best();
+      printf("generation %u: %.17g\n", g, best_rating());
+      runner_.record("iteration" + std::to_string(g) + ".md", best_member);
+    }
+    // The device may still be a generation or two behind, but the convergence is frozen once it stops
+    unsigned reason = Kokkos::atomic_load(&h_stop_reason_());
+    if(reason != NOT_STOPPED) {
+      printf("Stopping after generation %u: %s\n", g, stop_reason(reason));
+      break;
+    }
+    if(time_limit_ > 0 && timer.seconds() > time_limit_) {
+      printf("Stopping after generation %u: %s\n", g, stop_reason(OUT_OF_TIME));
+      break;
+    }
+
+    next_generation(eliteSize, mutationRate);
+    ranked = false;
+  }
+
+  if(!ranked) {
+    rank_population(eliteSize);
+  }
+  auto best_member = pull_best();
+  if(!reported || !ranked) {
+    printf("generation %u: %.17g\n", g, best_rating());
+  }
+
+  if(checkpoint_writer_) {
+    checkpoint_writer_->wait();
+  }
+
+  return best_member;
+}
+
+template<class Runner>
+void Genetic<Runner>::initialize(unsigned popSize) {
   // Allocate space for the Kokkos Views
   ratings_ = Kokkos::View<double*>("ratings", popSize);
   weights_ = Kokkos::View<double*>("weights", popSize);
+  permutation_ = Kokkos::View<unsigned*>("permutation", popSize);
+  rating_bounds_ = Kokkos::View<RatingBounds>("rating bounds");
+  bin_counts_ = Kokkos::View<unsigned*>("bin counts", popSize);
+  cutoff_ = Kokkos::View<EliteCutoff>("elite cutoff");
+  cutoff_members_ = Kokkos::View<unsigned*>("elite cutoff members", popSize);
+  next_cutoff_members_ = Kokkos::View<unsigned*>("elite cutoff members", popSize);
+  cutoff_bounds_ = Kokkos::View<Kokkos::MinMaxScalar<double>>("elite cutoff bounds");
+  is_elite_ = Kokkos::View<bool*>("is elite", popSize);
+  h_rating_bounds_ = Kokkos::View<RatingBounds, Kokkos::SharedHostPinnedSpace>("best rating");
+  if constexpr(nmutation_operators_ > 0) {
+    operator_probabilities_ = Kokkos::View<double*>("operator probabilities", nmutation_operators_);
+    operator_qualities_ = Kokkos::View<double*>("operator qualities", nmutation_operators_);
+    operator_credits_ = Kokkos::View<double*[2]>("operator credits", nmutation_operators_);
+    mutation_operators_ = Kokkos::View<unsigned*>("mutation operators", popSize);
+    mutation_baselines_ = Kokkos::View<double*>("mutation baselines", popSize);
+    Kokkos::deep_copy(operator_probabilities_, 1.0 / nmutation_operators_);
+  }
+  if constexpr(nobjectives_ > 0) {
+    objectives_ = Kokkos::View<double**>("objectives", popSize, nobjectives_);
+  }
+  convergence_ = Kokkos::View<Convergence>("convergence");
+  h_convergence_ = Kokkos::View<Convergence, Kokkos::SharedHostPinnedSpace>("convergence");
+  h_convergence_() = Convergence{-std::numeric_limits<double>::infinity(), 0, 1, NOT_STOPPED};
+  Kokkos::deep_copy(convergence_, h_convergence_);
+  h_stop_reason_ = Kokkos::View<unsigned, Kokkos::SharedHostPinnedSpace>("stop reason");
+  h_stop_reason_() = NOT_STOPPED;
+  profile_counters_ = Kokkos::View<ProfileCounters>("profile counters");
+  h_profile_counters_ = Kokkos::View<ProfileCounters, Kokkos::SharedHostPinnedSpace>("profile counters");
+  profiles_ = Kokkos::View<GenerationProfile*, Kokkos::HostSpace>("generation profiles", profile_interval_);
+  profile_generation_ = 0;
+  nprofiles_ = 0;
+  generation_ = 0;
+  current_profile_ = GenerationProfile{};
 
   make_initial_population(popSize);
 
-  for(unsigned g=0; g<generations; g++) {
-    std::cout << "generation " << g << ": ";
+  if constexpr(current_population_.rank == 2) {
+    best_member_ = MemberView("best member", current_population_.extent(1));
+    member_ = MemberView("member", current_population_.extent(1));
+  }
+  else {
+    best_member_ = MemberView("best member", current_population_.extent(1), current_population_.extent(2));
+    member_ = MemberView("member", current_population_.extent(1), current_population_.extent(2));
+  }
+  h_best_member_ = Kokkos::create_mirror_view(best_member_);
+  h_member_ = Kokkos::create_mirror_view(member_);
+}
 
-    rate_population();
-    sort();
+// Rates the current population and moves the elites to the end of permutation_
+template<class Runner>
+void Genetic<Runner>::rank_population(unsigned eliteSize) {
+  rate_population();
+  adapt_mutation_operators();
+  sort(eliteSize);
+  // The improved elites may have overtaken each other
+  if(local_search_members_ > 0 && local_search_steps_ > 0) {
+    local_search(eliteSize);
+    sort(eliteSize);
+  }
+}
 
-    if(g % 100 == 0) {
-      runner_.record("iteration" + std::to_string(g) + ".md", get_best_member());
-    }
+template<class Runner>
+void Genetic<Runner>::next_generation(unsigned eliteSize, double mutationRate) {
+  compute_weights();
+  breed_population(eliteSize);
+  mutate_population(mutationRate);
+  std::swap(current_population_, next_population_);
+  std::swap(current_positions_, next_positions_);
+  std::swap(current_states_, next_states_);
+  std::swap(current_changes_, next_changes_);
+  std::swap(current_nchanges_, next_nchanges_);
+  finish_profile();
+  generation_++;
+}
+
+template<class Runner>
+void Genetic<Runner>::set_delta_rating(bool delta_rating) {
+  delta_rating_ = delta_rating && genetic::rating_state<Runner>::value;
+}
+
+// Teams cooperate on a single population member rather than each thread handling one alone
+template<class Runner>
+void Genetic<Runner>::set_team_parallelism(bool team_parallelism) {
+  team_parallelism_ = team_parallelism;
+}
 
-    compute_weights();
-    breed_population(eliteSize);
-    mutate_population(mutationRate);
-    std::swap(current_population_, next_population_);
+template<class Runner>
+void Genetic<Runner>::set_selection(SelectionMethod selection, unsigned tournament_size) {
+  if(selection == PARETO_SELECTION && nobjectives_ == 0) {
+    Kokkos::abort("Pareto selection needs a runner with objectives");
   }
+  selection_ = selection;
+  tournament_size_ = tournament_size;
+}
 
-  std::cout << "generation " << generations << ": ";
-  rate_population();
-  sort();
+template<class Runner>
+void Genetic<Runner>::set_crossover(CrossoverMethod crossover) {
+  crossover_ = crossover;
+}
+
+// How many members of the initial population come from the runner's greedy solver instead of
+// random permutations
+template<class Runner>
+void Genetic<Runner>::set_greedy_seeds(unsigned greedy_seeds) {
+  greedy_seeds_ = greedy_seeds;
+}
+
+// How many generations run between progress reports
+template<class Runner>
+void Genetic<Runner>::set_report_interval(unsigned report_interval) {
+  report_interval_ = report_interval;
+}
+
+template<class Runner>
+void Genetic<Runner>::set_execution_space(const Kokkos::DefaultExecutionSpace& exec) {
+  exec_ = exec;
+}
+
+// Stop once the best rating reaches target_rating
+template<class Runner>
+void Genetic<Runner>::set_target_rating(double target_rating) {
+  target_rating_ = target_rating;
+}
+
+// Stop once the best rating has not improved for stagnation_limit generations
+template<class Runner>
+void Genetic<Runner>::set_stagnation_limit(unsigned stagnation_limit) {
+  stagnation_limit_ = stagnation_limit;
+}
+
+// Stop once the run has taken this many seconds
+template<class Runner>
+void Genetic<Runner>::set_time_limit(double seconds) {
+  time_limit_ = seconds;
+}
+
+// Stop once the best and worst ratings are closer than diversity_threshold
+template<class Runner>
+void Genetic<Runner>::set_diversity_threshold(double diversity_threshold) {
+  diversity_threshold_ = diversity_threshold;
+}
+
+// Multiply the mutation rate by factor every time the run stagnates, until it is max_scale times the original
+template<class Runner>
+void Genetic<Runner>::set_mutation_escalation(double factor, double max_scale) {
+  mutation_escalation_ = factor;
+  max_mutation_scale_ = max_scale;
+}
+
+// After every rating, each of the best nmembers members takes up to max_steps swaps, each time the
+// swap of two cells that raises its rating the most
+// Only runners with incremental ratings of 2D members can rate the swaps
+template<class Runner>
+void Genetic<Runner>::set_local_search(unsigned nmembers, unsigned max_steps) {
+  if constexpr(current_population_.rank == 3 && genetic::rating_state<Runner>::value) {
+    local_search_members_ = nmembers;
+    local_search_steps_ = max_steps;
+  }
+}
+
+template<class Runner>
+void Genetic<Runner>::set_deduplication(DeduplicationMethod deduplication) {
+  deduplication_ = deduplication;
+}
+
+// 0 never repairs, which shows how much the repair is worth
+template<class Runner>
+void Genetic<Runner>::set_repair_interval(unsigned repair_interval) {
+  repair_interval_ = repair_interval;
+}
+
+// 0 never rates a member from scratch once it has been, so its penalty terms may drift
+template<class Runner>
+void Genetic<Runner>::set_full_rating_interval(unsigned full_rating_interval) {
+  full_rating_interval_ = full_rating_interval;
+}
+
+// Islands need different seeds, or they all evolve the same population
+template<class Runner>
+void Genetic<Runner>::set_seed(unsigned seed) {
+  seed_ = seed;
+  rng_.seed(seed);
+  pool_ = Kokkos::Random_XorShift64_Pool<>(seed);
+}
+
+// Writes the state after rating every checkpoint_interval generations
+template<class Runner>
+void Genetic<Runner>::set_checkpoint(const std::string& filename, unsigned checkpoint_interval) {
+  checkpoint_filename_ = filename;
+  checkpoint_interval_ = checkpoint_interval;
+}
+
+// run() resumes from this checkpoint if it exists
+template<class Runner>
+void Genetic<Runner>::set_restart(const std::string& filename) {
+  restart_filename_ = filename;
+}
 
-  return get_best_member();
+// Times every stage of every generation and counts the work the kernels do, then prints the average of
+// every profile_interval generations and appends it to filename as CSV
+// The host waits for each stage to finish, so it is off by default
+template<class Runner>
+void Genetic<Runner>::set_profile(const std::string& filename, unsigned profile_interval) {
+  profile_filename_ = filename;
+  profile_interval_ = profile_interval;
+  // Callers stepping through initialize and next_generation themselves may turn this on afterwards
+  profiles_ = Kokkos::View<GenerationProfile*, Kokkos::HostSpace>("generation profiles", profile_interval_);
+  nprofiles_ = 0;
 }
 
 template<class Runner>
@@ -86,6 +655,40 @@ auto Genetic<Runner>::get_population_member(unsigned i, bool current) const {
   }
 }
 
+template<class Runner>
+auto Genetic<Runner>::get_member_positions(unsigned i, bool current) const {
+  if(current) {
+    return Kokkos::subview(current_positions_, i, Kokkos::ALL());
+  }
+  return Kokkos::subview(next_positions_, i, Kokkos::ALL());
+}
+
+// Rebuilds the position index of a member from scratch
+template<class Runner>
+void Genetic<Runner>::index_member(unsigned i, bool current) const {
+  auto member = get_population_member(i, current);
+  auto positions = get_member_positions(i, current);
+  for(unsigned cell=0; cell<positions.extent(0); cell++) {
+    positions(genetic::flat(member, cell)) = cell;
+  }
+}
+
+// Turns the current member i into a random permutation
+template<class Runner>
+KOKKOS_INLINE_FUNCTION
+void Genetic<Runner>::randomize_member(unsigned i) const {
+  auto member = get_population_member(i);
+  unsigned nentries = current_positions_.extent(1);
+  for(unsigned j=0; j<nentries; j++) {
+    genetic::flat(member, j) = j;
+  }
+  auto gen = pool_.get_state();
+  for(unsigned j=nentries-1; j>0; j--) {
+    genetic::swap(genetic::flat(member, j), genetic::flat(member, gen.rand(j+1)));
+  }
+  pool_.free_state(gen);
+}
+
 template<class Runner>
 void Genetic<Runner>::make_initial_population(unsigned popSize) {
   // Allocate memory for the population
@@ -97,117 +700,327 @@ void Genetic<Runner>::make_initial_population(unsigned popSize) {
   if(current_population_.rank == 3) {
     nentries *= current_population_.extent(2);
   }
-
-  // Create a vector of integers [0, popSize)
-  // We will permute this to get our population members
-  std::vector<unsigned> ints(nentries);
-  for(unsigned i=0; i<nentries; i++) {
-    ints[i] = i;
+  // The genes are 0 through nentries-1, and nentries itself marks empty cells while seeding greedily
+  if(nentries > std::numeric_limits<GeneType>::max()) {
+    Kokkos::abort("The members have too many genes for the runner's GeneType");
   }
 
-  // Get a host mirror of the device data
-  auto h_current_population = Kokkos::create_mirror_view(current_population_);
+  // Nobody has been rated yet, so nobody can be rated incrementally
+  current_states_ = Kokkos::View<RatingState*>("current rating states", popSize);
+  next_states_ = Kokkos::View<RatingState*>("next rating states", popSize);
+  current_changes_ = Kokkos::View<GeneType***>("current changes", popSize, max_tracked_changes_, 2);
+  next_changes_ = Kokkos::View<GeneType***>("next changes", popSize, max_tracked_changes_, 2);
+  current_nchanges_ = Kokkos::View<unsigned*>("current nchanges", popSize);
+  next_nchanges_ = Kokkos::View<unsigned*>("next nchanges", popSize);
+  Kokkos::deep_copy(current_nchanges_, max_tracked_changes_+1);
+  Kokkos::deep_copy(next_nchanges_, max_tracked_changes_+1);
+
+  current_positions_ = Kokkos::View<GeneType**>("current positions", popSize, nentries);
+  next_positions_ = Kokkos::View<GeneType**>("next positions", popSize, nentries);
+
+  // Every member starts as a random permutation, drawn on the device
+  Kokkos::parallel_for("random population", RangePolicy(exec_, 0, popSize), KOKKOS_CLASS_LAMBDA(unsigned i) {
+    randomize_member(i);
+  });
 
-  // Get a greedy solution
-  unsigned i=0;
+  // Replace the first few with the runner's greedy solutions
+  unsigned nseeds = Kokkos::min(greedy_seeds_, popSize);
   if constexpr(current_population_.rank == 2) {
-    i++;
-    auto greed = Kokkos::subview(h_current_population, 0, Kokkos::ALL());
-    runner_.greedy(greed);
+    // The mapper's greedy solver runs on the host
+    Kokkos::View<GeneType**> greedy_members("greedy members", nseeds, nentries);
+    auto h_greedy_members = Kokkos::create_mirror_view(greedy_members);
+    runner_.greedy(h_greedy_members);
+    Kokkos::deep_copy(exec_, greedy_members, h_greedy_members);
+    Kokkos::parallel_for("copy greedy members", RangePolicy(exec_, 0, nseeds), KOKKOS_CLASS_LAMBDA(unsigned i) {
+      for(unsigned j=0; j<nentries; j++) {
+        current_population_(i,j) = greedy_members(i,j);
+      }
+    });
+  }
+  else {
+    // The first greedy solution breaks ties deterministically, and the rest break them at random
+    Kokkos::parallel_for("greedy population", RangePolicy(exec_, 0, nseeds), KOKKOS_CLASS_LAMBDA(unsigned i) {
+      auto member = get_population_member(i);
+      auto positions = get_member_positions(i);
+      auto gen = pool_.get_state();
+      runner_.greedy(member, positions, gen, i > 0);
+      pool_.free_state(gen);
+    });
   }
 
-  // Populate the host mirror
-  for(; i<popSize; i++) {
-    // Randomly permute the integers
-    std::shuffle(ints.begin(), ints.end(), rng_);
+  // Find out where every gene lives
+  Kokkos::parallel_for("index population", RangePolicy(exec_, 0, popSize), KOKKOS_CLASS_LAMBDA(unsigned i) {
+    index_member(i);
+  });
+}
 
-    // Assign them to the host mirror
-    if constexpr(current_population_.rank == 2) {
-      for(unsigned j=0; j<current_population_.extent(1); j++) {
-        h_current_population(i,j) = ints[j];
-      }
+template<class Runner>
+void Genetic<Runner>::rate_population() {
+  unsigned popSize = current_population_.extent(0);
+  if(deduplication_ != KEEP_DUPLICATES) {
+    find_duplicates();
+  }
+  repair_population();
+
+  StageTimer stage_timer(*this, RATE_STAGE);
+  // The elites keep their states for many generations, so they need re-anchoring now and then
+  // This comes after the repair, which would otherwise redo every member that it already fixed
+  if(delta_rating_ && full_rating_interval_ > 0 && generation_ % full_rating_interval_ == 0) {
+    Kokkos::deep_copy(exec_, current_nchanges_, max_tracked_changes_+1);
+  }
+  bool memoize = deduplication_ == MEMOIZE_DUPLICATES;
+
+  // The constexpr can't live inside the device lambda
+  if constexpr(current_population_.rank == 3) {
+    if(team_parallelism_) {
+      rate_population_team();
     }
     else {
-      unsigned val = 0;
-      for(unsigned j=0; j<current_population_.extent(1); j++) {
-        for(unsigned k=0; k<current_population_.extent(2); k++) {
-          h_current_population(i,j,k) = ints[val];
-          val++;
+      Kokkos::parallel_for("rate population", RangePolicy(exec_, 0, popSize), KOKKOS_CLASS_LAMBDA(int i) {
+        if(memoize && originals_(i) != i) return;
+        bool verbose = false;
+        auto member = get_population_member(i);
+        auto positions = get_member_positions(i);
+        unsigned nchanges = current_nchanges_(i);
+        // Only update the terms touched by the changed cells if we can
+        if(delta_rating_ && nchanges <= max_tracked_changes_) {
+          auto changes = Kokkos::subview(current_changes_, i, Kokkos::ALL(), Kokkos::ALL());
+          ratings_(i) = runner_.rate_delta(member, positions, changes, nchanges, current_states_(i));
+          count_work(&ProfileCounters::delta_ratings, 1);
         }
-      }
+        else {
+          ratings_(i) = runner_.rate(member, positions, current_states_(i), verbose);
+          count_work(&ProfileCounters::full_ratings, 1);
+        }
+        store_objectives(i);
+        current_nchanges_(i) = 0;
+      });
     }
   }
+  else {
+    Kokkos::parallel_for("rate population", RangePolicy(exec_, 0, popSize), KOKKOS_CLASS_LAMBDA(int i) {
+      if(memoize && originals_(i) != i) return;
+//      bool verbose = i == 0 ? true : false; 
+      bool verbose = false;
+      auto member = get_population_member(i);
+      ratings_(i) = runner_.rate(member, verbose);
+      count_work(&ProfileCounters::full_ratings, 1);
+    });
+  }
 
-  // Copy data to device
-  Kokkos::deep_copy(current_population_, h_current_population);
+  if(memoize) {
+    copy_duplicates();
+  }
 }
 
+// Each team rates one member, working on a copy of it in scratch memory
+// Only runners with 2D members provide a team rating
 template<class Runner>
-void Genetic<Runner>::rate_population() {
+void Genetic<Runner>::rate_population_team() {
   unsigned popSize = current_population_.extent(0);
-  Kokkos::parallel_for("rate population", popSize, KOKKOS_CLASS_LAMBDA(int i) {
-//    bool verbose = i == 0 ? true : false; 
-    bool verbose = false;
+  unsigned nrows = current_population_.extent(1);
+  unsigned ncols = current_population_.extent(2);
+  unsigned ncells = nrows*ncols;
+
+  bool memoize = deduplication_ == MEMOIZE_DUPLICATES;
+
+  size_t scratch_size = ScratchView2D::shmem_size(nrows, ncols) + ScratchView1D::shmem_size(ncells);
+  Kokkos::TeamPolicy<> policy(exec_, popSize, Kokkos::AUTO);
+  policy.set_scratch_size(0, Kokkos::PerTeam(scratch_size));
+  Kokkos::parallel_for("rate population", policy, KOKKOS_CLASS_LAMBDA(const TeamMember& team) {
+    unsigned i = team.league_rank();
+    if(memoize && originals_(i) != i) return;
     auto member = get_population_member(i);
-    ratings_(i) = runner_.rate(member, verbose);
-  });
+    auto positions = get_member_positions(i);
+    ScratchView2D s_member(team.team_scratch(0), nrows, ncols);
+    ScratchView1D s_positions(team.team_scratch(0), ncells);
+    Kokkos::parallel_for(Kokkos::TeamThreadRange(team, ncells), [&](unsigned cell) {
+      s_member(cell / ncols, cell % ncols) = member(cell / ncols, cell % ncols);
+      s_positions(cell) = positions(cell);
+    });
+    team.team_barrier();
 
-  // Block until the GPU work is complete
-  Kokkos::fence();
+    // Only update the terms touched by the changed cells if we can
+    unsigned nchanges = current_nchanges_(i);
+    if(delta_rating_ && nchanges <= max_tracked_changes_) {
+      Kokkos::single(Kokkos::PerTeam(team), [&]() {
+        auto changes = Kokkos::subview(current_changes_, i, Kokkos::ALL(), Kokkos::ALL());
+        ratings_(i) = runner_.rate_delta(s_member, s_positions, changes, nchanges, current_states_(i));
+        count_work(&ProfileCounters::delta_ratings, 1);
+      });
+    }
+    else {
+      double rating = runner_.rate(team, s_member, s_positions, current_states_(i));
+      Kokkos::single(Kokkos::PerTeam(team), [&]() {
+        ratings_(i) = rating;
+        count_work(&ProfileCounters::full_ratings, 1);
+      });
+    }
+    Kokkos::single(Kokkos::PerTeam(team), [&]() {
+      store_objectives(i);
+      current_nchanges_(i) = 0;
+    });
+  });
 }
 
+// Points every member at the member with the highest index that has the same genes
+// Duplicates are usually children that match a parent; the elites have the highest indices, so
+// a child matching an elite copies the elite, whose incremental rating is nearly free
 template<class Runner>
-void Genetic<Runner>::compute_weights() {
-  unsigned popSize = ratings_.extent(0);
+void Genetic<Runner>::find_duplicates() {
+  StageTimer stage_timer(*this, RATE_STAGE);
+  unsigned popSize = current_population_.extent(0);
+  unsigned nentries = member_size();
+  if(originals_.extent(0) != popSize) {
+    genome_index_ = genetic::HashIndex("genome index", popSize);
+    genome_slots_ = Kokkos::View<unsigned*>("genome slots", popSize);
+    originals_ = Kokkos::View<unsigned*>("originals", popSize);
+  }
+
+  genome_index_.clear(exec_);
+  Kokkos::parallel_for("hash population", RangePolicy(exec_, 0, popSize), KOKKOS_CLASS_LAMBDA(unsigned i) {
+    genome_slots_(i) = genome_index_.insert(genetic::hash(get_population_member(i), nentries), i);
+  });
+
+  bool replace = deduplication_ == REPLACE_DUPLICATES;
+  Kokkos::parallel_for("find duplicates", RangePolicy(exec_, 0, popSize), KOKKOS_CLASS_LAMBDA(unsigned i) {
+    originals_(i) = i;
+    unsigned original = genome_index_.index(genome_slots_(i));
+    if(original == i) return;
+
+    // Different genes can share a hash, so only an exact match counts
+    auto member = get_population_member(i);
+    auto original_member = get_population_member(original);
+    for(unsigned j=0; j<nentries; j++) {
+      if(genetic::flat(member, j) != genetic::flat(original_member, j)) return;
+    }
+    count_work(&ProfileCounters::duplicates, 1);
 
-  // Block until the GPU work is complete
-  Kokkos::fence();
+    // Only the exact matches are replaced, and none of them is anyone's original
+    if(replace) {
+      randomize_member(i);
+      index_member(i);
+      current_nchanges_(i) = max_tracked_changes_+1;
+    }
+    else {
+      originals_(i) = original;
+    }
+  });
+}
 
-  // Subtract the lowest score from all weights
-  Kokkos::parallel_for("compute weights", popSize, KOKKOS_CLASS_LAMBDA(int i) {
-    weights_[i] = ratings_[i] - ratings_[0];
+// The duplicates take everything rating gave their originals, including the repaired genes
+template<class Runner>
+void Genetic<Runner>::copy_duplicates() {
+  unsigned popSize = current_population_.extent(0);
+  unsigned nentries = member_size();
+  Kokkos::parallel_for("copy duplicates", RangePolicy(exec_, 0, popSize), KOKKOS_CLASS_LAMBDA(unsigned i) {
+    unsigned original = originals_(i);
+    if(original == i) return;
+    ratings_(i) = ratings_(original);
+    current_states_(i) = current_states_(original);
+    current_nchanges_(i) = 0;
+    auto member = get_population_member(i);
+    auto original_member = get_population_member(original);
+    for(unsigned j=0; j<nentries; j++) {
+      genetic::flat(member, j) = genetic::flat(original_member, j);
+    }
+    for(unsigned j=0; j<current_positions_.extent(1); j++) {
+      current_positions_(i,j) = current_positions_(original,j);
+    }
+    for(unsigned k=0; k<nobjectives_; k++) {
+      objectives_(i,k) = objectives_(original,k);
+    }
   });
+}
+
+// Repairs the members that are about to be rated from scratch
+// The incremental ratings leave their members alone, since a repair could move any cell
+template<class Runner>
+void Genetic<Runner>::repair_population() {
+  if(repair_interval_ == 0 || generation_ % repair_interval_ != 0) return;
+  StageTimer stage_timer(*this, REPAIR_STAGE);
+  unsigned popSize = current_population_.extent(0);
+  bool memoize = deduplication_ == MEMOIZE_DUPLICATES;
 
-  // Block until all weights are computed since the next step uses them
-  Kokkos::fence();
+  // Only runners with 2D members have a repair
+  if constexpr(current_population_.rank == 3) {
+    if(team_parallelism_) {
+      Kokkos::parallel_for("repair population", Kokkos::TeamPolicy<>(exec_, popSize, Kokkos::AUTO),
+                           KOKKOS_CLASS_LAMBDA(const TeamMember& team) {
+        unsigned i = team.league_rank();
+        if(memoize && originals_(i) != i) return;
+        if(delta_rating_ && current_nchanges_(i) <= max_tracked_changes_) return;
+        runner_.fix_order(team, get_population_member(i), get_member_positions(i));
+        Kokkos::single(Kokkos::PerTeam(team), [&]() {
+          count_work(&ProfileCounters::repairs, 1);
+        });
+      });
+    }
+    else {
+      Kokkos::parallel_for("repair population", RangePolicy(exec_, 0, popSize), KOKKOS_CLASS_LAMBDA(unsigned i) {
+        if(memoize && originals_(i) != i) return;
+        if(delta_rating_ && current_nchanges_(i) <= max_tracked_changes_) return;
+        runner_.fix_order(get_population_member(i), get_member_positions(i));
+        count_work(&ProfileCounters::repairs, 1);
+      });
+    }
+  }
+}
 
-  // Compute the sum of all weights
-  double weight_sum;
-  Kokkos::parallel_reduce("Weight sum", popSize, KOKKOS_CLASS_LAMBDA (unsigned i, double& lsum ) {
-    lsum += weights_[i];
-  },weight_sum);
+template<class Runner>
+void Genetic<Runner>::compute_weights() {
+  StageTimer stage_timer(*this, WEIGHTS_STAGE);
+  // Tournaments compare the members directly
+  if(selection_ == TOURNAMENT_SELECTION || selection_ == PARETO_SELECTION) return;
 
-  // Block until the sum is computed since the next step uses it
-  Kokkos::fence();
+  unsigned popSize = ratings_.extent(0);
 
-  // Normalize the weights
-  Kokkos::parallel_for("Normalize weights", popSize, KOKKOS_CLASS_LAMBDA (unsigned i) {
-    weights_[i] /= weight_sum;
+  // Accumulate the rating of each member minus the lowest rating
+  // get_parent scales its random number by the total instead of normalizing the weights
+  Kokkos::parallel_scan("compute weights", RangePolicy(exec_, 0, popSize), KOKKOS_CLASS_LAMBDA(unsigned i, double& partial_sum, bool is_final) {
+    partial_sum += ratings_[permutation_[i]] - rating_bounds_().min_val;
+    if(is_final) {
+      weights_[i] = partial_sum;
+    }
   });
 
-  // Block until the weights are normalized since the next step uses them
-  Kokkos::fence();
+  // Stochastic universal sampling spaces its pointers evenly after a single random offset, and the
+  // children take them in a new random order every generation
+  if(selection_ == UNIVERSAL_SELECTION) {
+    sus_offset_ = std::uniform_real_distribution<double>(0.0, 1.0)(rng_);
+    sus_key_ = std::uniform_int_distribution<uint64_t>()(rng_);
+  }
 }
 
 template<class Runner>
 void Genetic<Runner>::breed_population(unsigned eliteSize) {
+  StageTimer stage_timer(*this, BREED_STAGE);
   unsigned popSize = current_population_.extent(0);
   unsigned breed_index_cutoff = popSize - eliteSize; // not inclusive
+  npointers_ = 2*breed_index_cutoff;
+
+  if(team_parallelism_) {
+    breed_population_team(eliteSize);
+    return;
+  }
 
-  Kokkos::parallel_for("Breeding", popSize, KOKKOS_CLASS_LAMBDA (unsigned i) {
+  Kokkos::parallel_for("Breeding", RangePolicy(exec_, 0, popSize), KOKKOS_CLASS_LAMBDA (unsigned i) {
     // Breed to obtain these indices
     if(i < breed_index_cutoff) {
       // Get the parents
-      unsigned pid1 = get_parent();
-      unsigned pid2 = pid1;
+      unsigned pid1 = get_parent(i);
+      unsigned pid2 = get_parent(i + breed_index_cutoff);
       while(pid2 == pid1) { // Make sure the parents are different
         pid2 = get_parent();
       }
       breed(pid1, pid2, i);
+      next_nchanges_(i) = max_tracked_changes_+1;
     }
     // Copy over the elite items to the new population
     else {
       unsigned elite_index = permutation_(i);
+      next_states_(i) = current_states_(elite_index);
+      next_nchanges_(i) = current_nchanges_(elite_index);
       for(unsigned j=0; j<current_population_.extent(1); j++) {
         if constexpr(current_population_.rank == 2) {
           next_population_(i,j) = current_population_(elite_index, j);
@@ -218,115 +1031,315 @@ void Genetic<Runner>::breed_population(unsigned eliteSize) {
           }
         }
       }
+      for(unsigned j=0; j<current_positions_.extent(1); j++) {
+        next_positions_(i,j) = current_positions_(elite_index,j);
+      }
     }
   });
+}
+
+// Each team breeds one child, keeping a copy of the mom's positions in scratch memory
+template<class Runner>
+void Genetic<Runner>::breed_population_team(unsigned eliteSize) {
+  unsigned popSize = current_population_.extent(0);
+  unsigned breed_index_cutoff = popSize - eliteSize; // not inclusive
+  unsigned nrows = current_population_.extent(1);
+  unsigned ncols = current_population_.rank == 3 ? current_population_.extent(2) : 1;
+  unsigned nentries = nrows*ncols;
 
-  // Block until the breeding is complete since the next step uses the results
-  Kokkos::fence();
+  // Every gene of the child looks up where dad's genes live in the mom
+  size_t scratch_size = ScratchView1D::shmem_size(nentries);
+  Kokkos::TeamPolicy<> policy(exec_, popSize, Kokkos::AUTO);
+  policy.set_scratch_size(0, Kokkos::PerTeam(scratch_size));
+  Kokkos::parallel_for("Breeding", policy, KOKKOS_CLASS_LAMBDA(const TeamMember& team) {
+    unsigned i = team.league_rank();
+    // Breed to obtain these indices
+    if(i < breed_index_cutoff) {
+      // Get the parents
+      Kokkos::pair<unsigned, unsigned> parents;
+      Kokkos::single(Kokkos::PerTeam(team), [&](Kokkos::pair<unsigned, unsigned>& pids) {
+        pids.first = get_parent(i);
+        pids.second = get_parent(i + breed_index_cutoff);
+        while(pids.second == pids.first) { // Make sure the parents are different
+          pids.second = get_parent();
+        }
+      }, parents);
+      breed(team, parents.first, parents.second, i);
+      Kokkos::single(Kokkos::PerTeam(team), [&]() {
+        next_nchanges_(i) = max_tracked_changes_+1;
+      });
+    }
+    // Copy over the elite items to the new population
+    else {
+      unsigned elite_index = permutation_(i);
+      Kokkos::parallel_for(Kokkos::TeamThreadRange(team, nentries), [&](unsigned j) {
+        if constexpr(current_population_.rank == 2) {
+          next_population_(i,j) = current_population_(elite_index, j);
+        }
+        else {
+          next_population_(i, j / ncols, j % ncols) = current_population_(elite_index, j / ncols, j % ncols);
+        }
+        next_positions_(i,j) = current_positions_(elite_index,j);
+      });
+      Kokkos::single(Kokkos::PerTeam(team), [&]() {
+        next_states_(i) = current_states_(elite_index);
+        next_nchanges_(i) = current_nchanges_(elite_index);
+      });
+    }
+  });
 }
 
+// draw selects the pointer used by stochastic universal sampling
+// Other methods (and out of range draws) pick a random parent
 template<class Runner>
-unsigned Genetic<Runner>:: get_parent() const {
-  // Get a random number between 0 and 1
+unsigned Genetic<Runner>:: get_parent(unsigned draw) const {
+  unsigned popSize = ratings_.extent(0);
   auto gen = pool_.get_state();
-  double r = gen.drand();
+
+  if(selection_ == TOURNAMENT_SELECTION || selection_ == PARETO_SELECTION) {
+    bool pareto = selection_ == PARETO_SELECTION;
+    unsigned winner = gen.rand(popSize);
+    for(unsigned t=1; t<tournament_size_; t++) {
+      unsigned challenger = gen.rand(popSize);
+      if(pareto ? is_better(challenger, winner) : ratings_(challenger) > ratings_(winner)) {
+        winner = challenger;
+      }
+    }
+    pool_.free_state(gen);
+    return winner;
+  }
+
+  // Get a random number between 0 and the sum of the weights
+  double total = weights_(popSize-1);
+  double r;
+  if(selection_ == UNIVERSAL_SELECTION && draw < npointers_) {
+    r = (sus_offset_ + genetic::permute(draw, npointers_, sus_key_)) / npointers_ * total;
+  }
+  else {
+    r = gen.drand() * total;
+  }
+
+  // If every member is equally fit, any of them will do
+  if(!(total > 0)) {
+    unsigned parent = gen.rand(popSize);
+    pool_.free_state(gen);
+    return permutation_(parent);
+  }
   pool_.free_state(gen);
 
-  // Determine which population member has been randomly chosen
-  double sum = 0.0;
-  unsigned parent = 0;
-  for(unsigned i=0; i<weights_.extent(0); i++) {
-    sum += weights_[i];
-    if(r < sum) {
-      parent = i;
-      break;
+  // Binary search for the first member whose cumulative weight exceeds r
+  unsigned lo = 0, hi = popSize-1;
+  while(lo < hi) {
+    unsigned mid = lo + (hi-lo)/2;
+    if(r < weights_[mid]) {
+      hi = mid;
+    }
+    else {
+      lo = mid+1;
     }
   }
-  return permutation_(parent);
+  return permutation_(lo);
 }
 
 template<class Runner>
 void Genetic<Runner>::breed(unsigned mom_index, unsigned dad_index, unsigned child_index) const {
-  using genetic::find;
+  using genetic::flat;
 
   // Get the parent and child population members
   auto mom = get_population_member(mom_index);
   auto dad = get_population_member(dad_index);
   auto child = get_population_member(child_index, false);
+  auto mom_positions = get_member_positions(mom_index);
+  unsigned ngenes = mom_positions.extent(0);
 
-  // Determine which genes are carried over from the mom
-  unsigned ngenes = current_population_.extent(current_population_.rank-1);
-  auto gen = pool_.get_state();
-  unsigned start_index = gen.rand(ngenes+1);
-  unsigned end_index = start_index;
-  while(end_index == start_index || Kokkos::abs((int)end_index - (int)start_index) >= ngenes) {
-    end_index = gen.rand(ngenes+1);
+  if(crossover_ == CYCLE_CROSSOVER) {
+    cycle_crossover(mom, dad, mom_positions, child);
   }
-  pool_.free_state(gen);
-  if(end_index < start_index) {
-    genetic::swap(start_index, end_index);
+  else {
+    // Determine which columns are carried over from the mom
+    auto crossover = get_crossover_points(current_population_.extent(current_population_.rank-1));
+    if(crossover_ == ORDER_CROSSOVER) {
+      order_crossover(mom, dad, mom_positions, child, crossover.first, crossover.second);
+    }
+    else {
+      unsigned repair_steps = 0;
+      for(unsigned cell=0; cell<ngenes; cell++) {
+        flat(child, cell) = pmx_gene(mom, dad, mom_positions, cell, crossover.first, crossover.second, repair_steps);
+      }
+      count_work(&ProfileCounters::repair_steps, repair_steps);
+    }
   }
+  index_member(child_index, false);
+}
 
-  // Copy those timeslots to the child
-  if constexpr(current_population_.rank == 2) {
-    for(unsigned i=start_index; i<end_index; i++) {
-      child(i) = mom(i);
-    }
+// Same as above, but the threads of a team split the genes of the child
+// Only PMX fills the genes independently; the other crossovers walk the member serially
+template<class Runner>
+void Genetic<Runner>::breed(const TeamMember& team, unsigned mom_index, unsigned dad_index, 
+                            unsigned child_index) const {
+  using genetic::flat;
+
+  // Get the parent and child population members
+  auto mom = get_population_member(mom_index);
+  auto dad = get_population_member(dad_index);
+  auto child = get_population_member(child_index, false);
+  auto mom_positions = get_member_positions(mom_index);
+  unsigned ngenes = mom_positions.extent(0);
+
+  // Copy the mom's positions to scratch since every gene of the child looks them up
+  ScratchView1D s_mom_positions(team.team_scratch(0), ngenes);
+  Kokkos::parallel_for(Kokkos::TeamThreadRange(team, ngenes), [&](unsigned gene) {
+    s_mom_positions(gene) = mom_positions(gene);
+  });
+  team.team_barrier();
+
+  if(crossover_ == CYCLE_CROSSOVER) {
+    Kokkos::single(Kokkos::PerTeam(team), [&]() {
+      cycle_crossover(mom, dad, s_mom_positions, child);
+    });
   }
   else {
-    for(unsigned i=0; i<child.extent(0); i++) {
-      for(unsigned j=start_index; j<end_index; j++) {
-        child(i, j) = mom(i, j);
-      }
+    // Determine which columns are carried over from the mom
+    unsigned ncols = current_population_.extent(current_population_.rank-1);
+    Kokkos::pair<unsigned, unsigned> crossover;
+    Kokkos::single(Kokkos::PerTeam(team), [&](Kokkos::pair<unsigned, unsigned>& points) {
+      points = get_crossover_points(ncols);
+    }, crossover);
+    if(crossover_ == ORDER_CROSSOVER) {
+      Kokkos::single(Kokkos::PerTeam(team), [&]() {
+        order_crossover(mom, dad, s_mom_positions, child, crossover.first, crossover.second);
+      });
+    }
+    else {
+      unsigned repair_steps;
+      Kokkos::parallel_reduce(Kokkos::TeamThreadRange(team, ngenes), [&](unsigned cell, unsigned& steps) {
+        flat(child, cell) = pmx_gene(mom, dad, s_mom_positions, cell, crossover.first, crossover.second, steps);
+      }, repair_steps);
+      Kokkos::single(Kokkos::PerTeam(team), [&]() {
+        count_work(&ProfileCounters::repair_steps, repair_steps);
+      });
     }
   }
+  team.team_barrier();
 
-  // Fill in the gaps with dad's info
-  Kokkos::pair<size_t, size_t> mom_indices(start_index, end_index);
-  if constexpr(current_population_.rank == 2) {
-    auto mom_genes = Kokkos::subview(mom, mom_indices);
-    for(unsigned i=0; i<child.extent(0); i++) {
-      // Skip the mom's indices
-      if (i >= start_index && i < end_index) continue;
-      // Determine whether the dad's value is already in child
-      unsigned current_index = i, new_index;
-      while(find(mom_genes, dad(current_index), new_index)) {
-        current_index = new_index + start_index;
-      }
-      child(i) = dad(current_index);
-    }
+  auto positions = get_member_positions(child_index, false);
+  Kokkos::parallel_for(Kokkos::TeamThreadRange(team, ngenes), [&](unsigned cell) {
+    positions(flat(child, cell)) = cell;
+  });
+}
+
+// The child inherits the cells in columns [start_index, end_index) from the mom
+// Any other cell takes dad's gene, unless the mom's segment already holds it; then it follows where
+// that gene lives in the mom and tries dad's gene there instead, adding one to repair_steps
+template<class Runner>
+template<class MemberType, class PositionType>
+typename Genetic<Runner>::GeneType Genetic<Runner>::pmx_gene(MemberType mom, MemberType dad, 
+    PositionType mom_positions, unsigned cell, unsigned start_index, unsigned end_index,
+    unsigned& repair_steps) const {
+  using genetic::flat;
+  unsigned ncols = current_population_.extent(current_population_.rank-1);
+  auto inherited = [&](unsigned c) {
+    return c % ncols >= start_index && c % ncols < end_index;
+  };
+
+  if(inherited(cell)) {
+    return flat(mom, cell);
   }
-  else {
-    auto mom_genes = Kokkos::subview(mom, Kokkos::ALL(), mom_indices);
-    for(unsigned r=0; r<child.extent(0); r++) {
-      for(unsigned c=0; c<child.extent(1); c++) {
-        // Skip the mom's indices
-        if (c >= start_index && c < end_index) continue;
-        // Determine whether the dad's value is already in child
-        Kokkos::pair<size_t, size_t> current_index(r,c), new_index;
-        while(find(mom_genes, dad(current_index.first, current_index.second), new_index)) {
-          current_index.first = new_index.first;
-          current_index.second = new_index.second + start_index;
-        }
-        child(r, c) = dad(current_index.first, current_index.second);
-      }
+  unsigned current_cell = cell;
+  while(inherited(mom_positions(flat(dad, current_cell)))) {
+    current_cell = mom_positions(flat(dad, current_cell));
+    repair_steps++;
+  }
+  return flat(dad, current_cell);
+}
+
+// The child inherits the cells in columns [start_index, end_index) from the mom
+// The other cells get the rest of dad's genes in his order, both starting after the last inherited cell
+template<class Runner>
+template<class MemberType, class PositionType, class ChildType>
+void Genetic<Runner>::order_crossover(MemberType mom, MemberType dad, PositionType mom_positions,
+                                      ChildType child, unsigned start_index, unsigned end_index) const {
+  using genetic::flat;
+  unsigned ngenes = mom_positions.extent(0);
+  unsigned ncols = current_population_.extent(current_population_.rank-1);
+  auto inherited = [&](unsigned c) {
+    return c % ncols >= start_index && c % ncols < end_index;
+  };
+
+  unsigned first_cell = ngenes - ncols + end_index;
+  unsigned dad_cell = first_cell;
+  for(unsigned k=0; k<ngenes; k++) {
+    unsigned cell = (first_cell + k) % ngenes;
+    if(inherited(cell)) {
+      flat(child, cell) = flat(mom, cell);
+      continue;
+    }
+    while(inherited(mom_positions(flat(dad, dad_cell % ngenes)))) {
+      dad_cell++;
     }
+    flat(child, cell) = flat(dad, dad_cell % ngenes);
+    dad_cell++;
+  }
+}
+
+// Following dad's gene in each cell to where the mom keeps it splits the cells into cycles
+// The child takes the odd cycles from the mom and the even ones from dad
+template<class Runner>
+template<class MemberType, class PositionType, class ChildType>
+void Genetic<Runner>::cycle_crossover(MemberType mom, MemberType dad, PositionType mom_positions,
+                                      ChildType child) const {
+  using genetic::flat;
+  unsigned ngenes = mom_positions.extent(0);
+  // No gene can have this value, so it marks the cells that haven't been filled
+  constexpr GeneType unfilled = std::numeric_limits<GeneType>::max();
+
+  for(unsigned cell=0; cell<ngenes; cell++) {
+    flat(child, cell) = unfilled;
   }
+  bool from_mom = true;
+  for(unsigned first_cell=0; first_cell<ngenes; first_cell++) {
+    if(flat(child, first_cell) != unfilled) continue;
+    unsigned cell = first_cell;
+    do {
+      flat(child, cell) = from_mom ? flat(mom, cell) : flat(dad, cell);
+      cell = mom_positions(flat(dad, cell));
+    } while(cell != first_cell);
+    from_mom = !from_mom;
+  }
+}
+
+// Picks the range [first, second) of genes a child inherits from its mom
+template<class Runner>
+Kokkos::pair<unsigned, unsigned> Genetic<Runner>::get_crossover_points(unsigned ngenes) const {
+  auto gen = pool_.get_state();
+  unsigned start_index = gen.rand(ngenes+1);
+  unsigned end_index = start_index;
+  while(end_index == start_index || Kokkos::abs((int)end_index - (int)start_index) >= ngenes) {
+    end_index = gen.rand(ngenes+1);
+  }
+  pool_.free_state(gen);
+  if(end_index < start_index) {
+    genetic::swap(start_index, end_index);
+  }
+  return Kokkos::pair<unsigned, unsigned>(start_index, end_index);
 }
 
 template<class Runner>
 void Genetic<Runner>::mutate_population(double mutationRate) {
+  StageTimer stage_timer(*this, MUTATE_STAGE);
   using genetic::swap;
   unsigned popSize = current_population_.extent(0);
 
   // The constexpr can't live inside the device lambda
   if constexpr(current_population_.rank == 2) {
-    Kokkos::parallel_for("Mutations", popSize, KOKKOS_CLASS_LAMBDA(unsigned p) {
+    Kokkos::parallel_for("Mutations", RangePolicy(exec_, 0, popSize), KOKKOS_CLASS_LAMBDA(unsigned p) {
       // Don't mutate the best population member
       if (p == popSize-1) return;
+      double rate = mutationRate * convergence_().mutation_scale;
+      unsigned nmutations = 0;
       for(unsigned i=0; i<current_population_.extent(1); i++) {
         auto gen = pool_.get_state();
-        if(gen.drand() < mutationRate) {
+        if(gen.drand() < rate) {
           // Swap the element with another
           unsigned i2 = i;
           while(i2 == i || runner_.out_of_bounds(current_population_(p,i2))) {
@@ -334,73 +1347,1012 @@ void Genetic<Runner>::mutate_population(double mutationRate) {
           }
           pool_.free_state(gen);
           swap(next_population_(p,i), next_population_(p,i2));
+          next_positions_(p, next_population_(p,i)) = i;
+          next_positions_(p, next_population_(p,i2)) = i2;
+          nmutations++;
         }
         else {
           pool_.free_state(gen);
         }
       }
+      count_work(&ProfileCounters::mutations, nmutations);
+    });
+  }
+  else if constexpr(nmutation_operators_ > 0) {
+    using genetic::flat;
+    unsigned breed_index_cutoff = npointers_ / 2; // The elites were copied after the children
+    Kokkos::parallel_for("Mutations", RangePolicy(exec_, 0, popSize), KOKKOS_CLASS_LAMBDA(unsigned p) {
+      // Don't mutate the best population member
+      if (p == popSize-1) return;
+      auto member = get_population_member(p, false);
+      auto positions = get_member_positions(p, false);
+      auto record = [&](unsigned cell) {
+        record_change(p, cell, flat(member, cell));
+      };
+      double rate = mutationRate * convergence_().mutation_scale;
+      unsigned nmutations = 0;
+      // Every mutation of a member uses the same operator, so the change in its rating is all that operator's
+      auto gen = pool_.get_state();
+      unsigned op = get_mutation_operator(gen.drand());
+      for(unsigned cell=0; cell<positions.extent(0); cell++) {
+        if(gen.drand() < rate) {
+          runner_.mutate(op, member, positions, cell, gen, record);
+          nmutations++;
+        }
+      }
+      pool_.free_state(gen);
+      // Only the elites were whole before mutating, so only they show what the operators did
+      if(p >= breed_index_cutoff && nmutations > 0) {
+        mutation_operators_(p) = op+1;
+        mutation_baselines_(p) = ratings_(permutation_(p));
+      }
+      count_work(&ProfileCounters::mutations, nmutations);
     });
   }
   else {
-    Kokkos::parallel_for("Mutations", popSize, KOKKOS_CLASS_LAMBDA(unsigned p) {
+    Kokkos::parallel_for("Mutations", RangePolicy(exec_, 0, popSize), KOKKOS_CLASS_LAMBDA(unsigned p) {
       // Don't mutate the best population member
       if (p == popSize-1) return;
+      double rate = mutationRate * convergence_().mutation_scale;
+      unsigned nmutations = 0;
       for(unsigned i=0; i<current_population_.extent(1); i++) {
         for(unsigned j=0; j<current_population_.extent(2); j++) {
           auto gen = pool_.get_state();
-          if(gen.drand() < mutationRate) {
+          if(gen.drand() < rate) {
             // Swap the element with another slot
             unsigned j2 = j;
             while(j2 == j || runner_.out_of_bounds(current_population_(p,i,j2))) {
               j2 = gen.rand(current_population_.extent(2));
             }
             pool_.free_state(gen);
+            unsigned nrooms = current_population_.extent(2);
+            record_change(p, i*nrooms+j, next_population_(p,i,j));
+            record_change(p, i*nrooms+j2, next_population_(p,i,j2));
             swap(next_population_(p,i,j), next_population_(p,i,j2));
+            next_positions_(p, next_population_(p,i,j)) = i*nrooms+j;
+            next_positions_(p, next_population_(p,i,j2)) = i*nrooms+j2;
+            nmutations++;
           }
           else {
             pool_.free_state(gen);
           }
         }
       }
+      count_work(&ProfileCounters::mutations, nmutations);
+    });
+  }
+}
+
+// Each team hill-climbs one of the best members, with its threads rating different swaps of two cells
+// The swaps are rated incrementally from the member's rating state, so the member itself only changes
+// when the best swap is kept; the search stops early once no swap improves the rating
+template<class Runner>
+void Genetic<Runner>::local_search(unsigned eliteSize) {
+  if constexpr(current_population_.rank == 3 && genetic::rating_state<Runner>::value) {
+    StageTimer stage_timer(*this, SEARCH_STAGE);
+    using genetic::flat;
+    using genetic::swap;
+    typedef Kokkos::MaxLoc<double, uint64_t> BestSwap;
+    unsigned popSize = current_population_.extent(0);
+    unsigned ncells = current_population_.extent(1)*current_population_.extent(2);
+    // Every pair of cells, which overflows 32 bits for the largest schedules a GeneType can index
+    uint64_t npairs = uint64_t(ncells)*(ncells-1)/2;
+    // Only the elites are known to be the best members
+    unsigned nmembers = Kokkos::min(local_search_members_, Kokkos::max(eliteSize, 1u));
+
+    Kokkos::TeamPolicy<> policy(exec_, nmembers, Kokkos::AUTO);
+    Kokkos::parallel_for("local search", policy, KOKKOS_CLASS_LAMBDA(const TeamMember& team) {
+      unsigned i = permutation_(popSize-1-team.league_rank());
+      auto member = get_population_member(i);
+      auto positions = get_member_positions(i);
+      for(unsigned step=0; step<local_search_steps_; step++) {
+        // Every thread reads the rating before the reduction, so none of them sees the update below
+        double rating = ratings_(i);
+        typename BestSwap::value_type best;
+        Kokkos::parallel_reduce(Kokkos::TeamThreadRange(team, npairs), [&](uint64_t pair,
+                                typename BestSwap::value_type& lbest) {
+          auto cells = genetic::triangle_pair(pair, ncells);
+          unsigned cell1 = cells.first, cell2 = cells.second;
+          // Swapping two empty cells changes nothing
+          if(runner_.out_of_bounds(flat(member, cell1)) && runner_.out_of_bounds(flat(member, cell2))) return;
+          RatingState state = current_states_(i);
+          double swapped_rating = runner_.rate_swap(member, positions, cell1, cell2, state);
+          if(swapped_rating > lbest.val) {
+            lbest.val = swapped_rating;
+            lbest.loc = pair;
+          }
+        }, BestSwap(best));
+        if(best.val <= rating) break;
+
+        Kokkos::single(Kokkos::PerTeam(team), [&]() {
+          auto cells = genetic::triangle_pair(best.loc, ncells);
+          unsigned cell1 = cells.first, cell2 = cells.second;
+          ratings_(i) = runner_.rate_swap(member, positions, cell1, cell2, current_states_(i));
+          store_objectives(i);
+          swap(flat(member, cell1), flat(member, cell2));
+          positions(flat(member, cell1)) = cell1;
+          positions(flat(member, cell2)) = cell2;
+          count_work(&ProfileCounters::local_swaps, 1);
+        });
+        team.team_barrier();
+      }
+    });
+  }
+}
+
+// Roulette over the operator probabilities
+template<class Runner>
+unsigned Genetic<Runner>::get_mutation_operator(double draw) const {
+  for(unsigned op=0; op+1<nmutation_operators_; op++) {
+    if(draw < operator_probabilities_(op)) return op;
+    draw -= operator_probabilities_(op);
+  }
+  return nmutation_operators_-1;
+}
+
+// Credits the change in each mutated elite's rating to the operator that mutated it, and moves each
+// operator's quality towards its average change. Improvements are rare near the optimum, so how
+// little an operator hurts matters as much as how often it helps.
+// The probability of picking the best operator then pursues the most it can be while none of the
+// others drops below min_operator_probability_, so the others can still take over if they get better
+template<class Runner>
+void Genetic<Runner>::adapt_mutation_operators() {
+  if constexpr(nmutation_operators_ > 0) {
+    unsigned popSize = ratings_.extent(0);
+    Kokkos::parallel_for("credit mutations", RangePolicy(exec_, 0, popSize), KOKKOS_CLASS_LAMBDA(unsigned p) {
+      if(mutation_operators_(p) == 0) return;
+      unsigned op = mutation_operators_(p)-1;
+      Kokkos::atomic_add(&operator_credits_(op, 0), 1.0);
+      Kokkos::atomic_add(&operator_credits_(op, 1), ratings_(p) - mutation_baselines_(p));
+      mutation_operators_(p) = 0;
+    });
+    Kokkos::parallel_for("adapt mutations", RangePolicy(exec_, 0, 1), KOKKOS_CLASS_LAMBDA(unsigned) {
+      for(unsigned op=0; op<nmutation_operators_; op++) {
+        if(operator_credits_(op, 0) > 0) {
+          double change = operator_credits_(op, 1) / operator_credits_(op, 0);
+          operator_qualities_(op) += operator_adaptation_rate_ * (change - operator_qualities_(op));
+        }
+        operator_credits_(op, 0) = operator_credits_(op, 1) = 0;
+      }
+      unsigned best = 0;
+      for(unsigned op=1; op<nmutation_operators_; op++) {
+        if(operator_qualities_(op) > operator_qualities_(best)) best = op;
+      }
+      double max_probability = 1 - (nmutation_operators_-1)*min_operator_probability_;
+      for(unsigned op=0; op<nmutation_operators_; op++) {
+        double target = op == best ? max_probability : min_operator_probability_;
+        operator_probabilities_(op) += operator_adaptation_rate_ * (target - operator_probabilities_(op));
+      }
+    });
+  }
+}
+
+// Only runners with objectives have any to store
+template<class Runner>
+void Genetic<Runner>::store_objectives(unsigned i) const {
+  if constexpr(nobjectives_ > 0) {
+    runner_.objectives(current_states_(i), Kokkos::subview(objectives_, i, Kokkos::ALL()));
+  }
+}
+
+// Remembers the value a cell held before it was first modified
+template<class Runner>
+void Genetic<Runner>::record_change(unsigned p, unsigned cell, unsigned old_value) const {
+  unsigned nchanges = next_nchanges_(p);
+  if(nchanges > max_tracked_changes_) return;
+  for(unsigned c=0; c<nchanges; c++) {
+    if(next_changes_(p,c,0) == cell) return;
+  }
+  if(nchanges < max_tracked_changes_) {
+    next_changes_(p,nchanges,0) = cell;
+    next_changes_(p,nchanges,1) = old_value;
+  }
+  next_nchanges_(p) = nchanges+1;
+}
+
+// Moves the eliteSize best members to the end of permutation_, with the best one last
+// The rest of the population is left in index order, since the weights do not need it sorted
+template<class Runner>
+void Genetic<Runner>:: sort(unsigned eliteSize) {
+  StageTimer stage_timer(*this, SORT_STAGE);
+  unsigned popSize = ratings_.extent(0);
+  unsigned nbins = bin_counts_.extent(0);
+  unsigned nelites = Kokkos::max(eliteSize, 1u); // The best member is always placed last
+
+  // Find the lowest and highest ratings in one pass, leaving the result on the device
+  typedef Kokkos::MinMaxLoc<double, unsigned, Kokkos::DefaultExecutionSpace::memory_space> BoundsReducer;
+  Kokkos::parallel_reduce("rating bounds", RangePolicy(exec_, 0, popSize), KOKKOS_CLASS_LAMBDA(unsigned i, RatingBounds& bounds) {
+    if(ratings_(i) < bounds.min_val) {
+      bounds.min_val = ratings_(i);
+      bounds.min_loc = i;
+    }
+    if(ratings_(i) > bounds.max_val) {
+      bounds.max_val = ratings_(i);
+      bounds.max_loc = i;
+    }
+  }, BoundsReducer(rating_bounds_));
+  if(selection_ == PARETO_SELECTION) {
+    rank_fronts();
+  }
+
+  // Histogram the ratings, or the fronts
+  Kokkos::deep_copy(exec_, bin_counts_, 0);
+  Kokkos::parallel_for("bin ratings", RangePolicy(exec_, 0, popSize), KOKKOS_CLASS_LAMBDA(unsigned i) {
+    Kokkos::atomic_increment(&bin_counts_(get_bin(i)));
+  });
+  Kokkos::parallel_for("reset elite cutoff", RangePolicy(exec_, 0, 1), KOKKOS_CLASS_LAMBDA(unsigned) {
+    cutoff_().needed = nelites;
+  });
+  find_cutoff();
+
+  // Everything above the cutoff bin is elite; gather the members of the cutoff bin
+  Kokkos::parallel_scan("gather elite cutoff", RangePolicy(exec_, 0, popSize), KOKKOS_CLASS_LAMBDA(unsigned i, unsigned& nmembers, bool is_final) {
+    unsigned bin = get_bin(i);
+    if(is_final) {
+      is_elite_(i) = bin > cutoff_().bin;
+      if(bin == cutoff_().bin) {
+        cutoff_members_(nmembers) = i;
+        if(i == rating_bounds_().max_loc) {
+          cutoff_().best_position = nmembers;
+        }
+      }
+    }
+    if(bin == cutoff_().bin) {
+      nmembers++;
+    }
+  });
+  narrow_cutoff();
+
+  // Bin the members of the cutoff bin again over their own range, which splits them up unless they tie
+  for(unsigned round=0; round<cutoff_rounds_; round++) {
+    cutoff_bounds();
+    Kokkos::deep_copy(exec_, bin_counts_, 0);
+    Kokkos::parallel_for("bin elite cutoff", RangePolicy(exec_, 0, popSize), KOKKOS_CLASS_LAMBDA(unsigned m) {
+      if(m >= cutoff_().ncandidates) return;
+      Kokkos::atomic_increment(&bin_counts_(get_cutoff_bin(cutoff_members_(m))));
+    });
+    find_cutoff();
+    Kokkos::parallel_scan("gather elite cutoff", RangePolicy(exec_, 0, popSize), KOKKOS_CLASS_LAMBDA(unsigned m, unsigned& nmembers, bool is_final) {
+      if(m >= cutoff_().ncandidates) return;
+      unsigned i = cutoff_members_(m);
+      unsigned bin = get_cutoff_bin(i);
+      if(is_final) {
+        is_elite_(i) = bin > cutoff_().bin;
+        if(bin == cutoff_().bin) {
+          next_cutoff_members_(nmembers) = i;
+          if(i == rating_bounds_().max_loc) {
+            cutoff_().best_position = nmembers;
+          }
+        }
+      }
+      if(bin == cutoff_().bin) {
+        nmembers++;
+      }
     });
+    narrow_cutoff();
+    std::swap(cutoff_members_, next_cutoff_members_);
   }
 
-  // Block until the mutations are complete since the next step uses the results
-  Kokkos::fence();
+  // The members left over almost always tie, and the ties are ranked by index in one pass
+  // Anything else is compared pairwise, but only a few members can survive that many rounds without tying
+  cutoff_bounds();
+  Kokkos::parallel_for("resolve elite cutoff", RangePolicy(exec_, 0, popSize), KOKKOS_CLASS_LAMBDA(unsigned m) {
+    const EliteCutoff& cutoff = cutoff_();
+    unsigned ncandidates = cutoff.ncandidates;
+    if(m >= ncandidates) return;
+
+    unsigned needed = cutoff.needed;
+    unsigned i = cutoff_members_(m);
+    if(cutoff_bounds_().min_val == cutoff_bounds_().max_val) {
+      // The best member comes first, then the highest indices
+      bool has_best = cutoff.best_position < ncandidates;
+      unsigned nafter = ncandidates-1-m - (has_best && cutoff.best_position > m ? 1 : 0);
+      is_elite_(i) = needed > 0 && (m == cutoff.best_position || nafter + (has_best ? 1 : 0) < needed);
+      return;
+    }
+    unsigned nbetter = 0;
+    for(unsigned n=0; n<ncandidates && nbetter < needed; n++) {
+      if(is_better(cutoff_members_(n), i)) {
+        nbetter++;
+      }
+    }
+    is_elite_(i) = nbetter < needed;
+  });
+
+  // Compact the members into the permutation with the elites at the end
+  Kokkos::parallel_scan("permute population", RangePolicy(exec_, 0, popSize), KOKKOS_CLASS_LAMBDA(unsigned i, unsigned& nbefore, bool is_final) {
+    bool elite = is_elite_(i);
+    if(is_final) {
+      unsigned best = rating_bounds_().max_loc;
+      if(i == best) {
+        permutation_(popSize-1) = i;
+      }
+      else if(elite) {
+        permutation_(popSize - nelites + nbefore - (best < i ? 1 : 0)) = i;
+      }
+      else {
+        permutation_(i - nbefore) = i;
+      }
+    }
+    if(elite) {
+      nbefore++;
+    }
+  });
 }
 
+// Sorts the population into non-dominated fronts, and measures how far each member is from its
+// neighbours in its front; a member dominates another if it is no worse in every objective and better
+// in at least one. Every pair of members is compared once, and the fronts are then peeled off one at a
+// time by a single team, so the host never has to wait for them
+// The best rated member is kept in the first front with the largest crowding distance, since sort
+// needs it to be elite
 template<class Runner>
-void Genetic<Runner>:: sort() {
-  // Kokkos uses a bin sort which requires the minimum and maximum elements of the array
-  using KeyViewType = Kokkos::View<double*>;
-  using BinOp = Kokkos::BinOp1D<KeyViewType>;
-  using Kokkos::Experimental::minmax_element;
-  using Kokkos::Experimental::begin;
-  double min, max;
-  auto itpair = minmax_element(Kokkos::DefaultExecutionSpace(), ratings_);
-  Kokkos::deep_copy(min, Kokkos::subview(ratings_, itpair.first-begin(ratings_)));
-  Kokkos::deep_copy(max, Kokkos::subview(ratings_, itpair.second-begin(ratings_)));
-  BinOp bin_op(ratings_.extent(0), min, max);
-  Kokkos::BinSort<KeyViewType, BinOp> bin_sort(ratings_, bin_op);
-  bin_sort.create_permute_vector();
-  bin_sort.sort(ratings_);
-  permutation_ = bin_sort.get_permute_vector();
-  printf("%.17g\n", max);
+void Genetic<Runner>::rank_fronts() {
+  if constexpr(nobjectives_ > 0) {
+    unsigned popSize = ratings_.extent(0);
+    unsigned nwords = (popSize+63)/64;
+    if(fronts_.extent(0) != popSize) {
+      fronts_ = Kokkos::View<unsigned*>("fronts", popSize);
+      crowding_ = Kokkos::View<double*>("crowding distances", popSize);
+      dominators_ = Kokkos::View<uint64_t**>("dominators", popSize, nwords);
+      remaining_ = Kokkos::View<uint64_t*>("remaining members", nwords);
+    }
+
+    // Each thread finds which of 64 members dominate member i
+    Kokkos::parallel_for("find dominators", RangePolicy(exec_, 0, popSize*nwords), KOKKOS_CLASS_LAMBDA(unsigned iw) {
+      unsigned i = iw / nwords, w = iw % nwords;
+      uint64_t word = 0;
+      // Rounding can tie the best rated member with one that dominates it
+      if(i != rating_bounds_().max_loc) {
+        for(unsigned j=w*64; j<Kokkos::min(w*64+64, popSize); j++) {
+          bool no_worse = true, better = false;
+          for(unsigned k=0; k<nobjectives_ && no_worse; k++) {
+            no_worse = objectives_(j,k) <= objectives_(i,k);
+            better = better || objectives_(j,k) < objectives_(i,k);
+          }
+          if(no_worse && better) {
+            word |= uint64_t(1) << (j%64);
+          }
+        }
+      }
+      dominators_(i,w) = word;
+    });
+    Kokkos::parallel_for("reset fronts", RangePolicy(exec_, 0, nwords), KOKKOS_CLASS_LAMBDA(unsigned w) {
+      unsigned nbits = Kokkos::min(64u, popSize - w*64);
+      remaining_(w) = nbits == 64 ? ~uint64_t(0) : (uint64_t(1) << nbits) - 1;
+    });
+    Kokkos::deep_copy(exec_, fronts_, popSize);
+
+    // The next front is every remaining member that no remaining member dominates
+    // Dominance is transitive, so there is always at least one
+    // The team is as large as the backend allows, since it is the only one
+    auto peel_fronts = KOKKOS_CLASS_LAMBDA(const TeamMember& team) {
+      unsigned nranked = 0;
+      for(unsigned front=0; nranked<popSize; front++) {
+        unsigned nfront = 0;
+        Kokkos::parallel_reduce(Kokkos::TeamThreadRange(team, popSize), [&](unsigned i, unsigned& n) {
+          if(fronts_(i) < popSize) return;
+          for(unsigned w=0; w<nwords; w++) {
+            if(dominators_(i,w) & remaining_(w)) return;
+          }
+          fronts_(i) = front;
+          n++;
+        }, nfront);
+        team.team_barrier();
+        Kokkos::parallel_for(Kokkos::TeamThreadRange(team, nwords), [&](unsigned w) {
+          for(unsigned j=w*64; j<Kokkos::min(w*64+64, popSize); j++) {
+            if(fronts_(j) == front) {
+              remaining_(w) &= ~(uint64_t(1) << (j%64));
+            }
+          }
+        });
+        team.team_barrier();
+        nranked += nfront;
+      }
+    };
+    Kokkos::TeamPolicy<> probe(exec_, 1, 1);
+    unsigned team_size = probe.team_size_max(peel_fronts, Kokkos::ParallelForTag());
+    Kokkos::parallel_for("peel fronts", Kokkos::TeamPolicy<>(exec_, 1, team_size), peel_fronts);
+
+    // The distance along each objective is the gap between a member's neighbours, relative to the
+    // spread of the front; members at either end of a front are infinitely far from the rest
+    // Equal values are ordered by index, so members that tie still have neighbours
+    Kokkos::parallel_for("crowding distances", RangePolicy(exec_, 0, popSize), KOKKOS_CLASS_LAMBDA(unsigned i) {
+      constexpr double infinity = Kokkos::Experimental::infinity_v<double>;
+      unsigned front = fronts_(i);
+      double distance = i == rating_bounds_().max_loc ? infinity : 0;
+      for(unsigned k=0; k<nobjectives_ && distance < infinity; k++) {
+        double value = objectives_(i,k);
+        double lowest = value, highest = value, below = -infinity, above = infinity;
+        for(unsigned j=0; j<popSize; j++) {
+          if(j == i || fronts_(j) != front) continue;
+          double other = objectives_(j,k);
+          lowest = Kokkos::min(lowest, other);
+          highest = Kokkos::max(highest, other);
+          if(other < value || (other == value && j < i)) {
+            below = Kokkos::max(below, other);
+          }
+          else {
+            above = Kokkos::min(above, other);
+          }
+        }
+        if(highest > lowest) {
+          distance += (above - below) / (highest - lowest);
+        }
+      }
+      crowding_(i) = distance;
+    });
+  }
 }
 
+// Bins evenly divide the range between the lowest and highest ratings
+// With PARETO_SELECTION each front has its own bin, the first front in the highest one
 template<class Runner>
-auto Genetic<Runner>::get_best_member() {
-  unsigned best_pop_subscript;
-  unsigned popSize = permutation_.extent(0);
-  Kokkos::deep_copy(best_pop_subscript, Kokkos::subview(permutation_, popSize-1));
-  auto h_population = Kokkos::create_mirror_view(current_population_);
-  Kokkos::deep_copy(h_population, current_population_);
-  if constexpr(h_population.rank == 2) {
-    return Kokkos::subview(h_population, best_pop_subscript, Kokkos::ALL());
+unsigned Genetic<Runner>::get_bin(unsigned i) const {
+  unsigned nbins = bin_counts_.extent(0);
+  if(selection_ == PARETO_SELECTION) {
+    return nbins-1-fronts_(i);
+  }
+  double width = rating_bounds_().max_val - rating_bounds_().min_val;
+  if(!(width > 0)) return 0;
+  unsigned bin = (ratings_(i) - rating_bounds_().min_val) / width * nbins;
+  return Kokkos::min(bin, nbins-1);
+}
+
+// Walks down from the highest bin to find the one holding the worst of the needed elites
+template<class Runner>
+void Genetic<Runner>::find_cutoff() {
+  unsigned nbins = bin_counts_.extent(0);
+  unsigned ncandidates = cutoff_members_.extent(0);
+  Kokkos::parallel_for("reset elite cutoff", RangePolicy(exec_, 0, 1), KOKKOS_CLASS_LAMBDA(unsigned) {
+    cutoff_().bin = nbins;
+    cutoff_().nabove = 0;
+    cutoff_().best_position = ncandidates;
+  });
+  Kokkos::parallel_scan("find elite cutoff", RangePolicy(exec_, 0, nbins), KOKKOS_CLASS_LAMBDA(unsigned b, unsigned& nabove, bool is_final) {
+    unsigned bin = nbins-1-b;
+    unsigned needed = cutoff_().needed;
+    if(is_final && nabove < needed && nabove + bin_counts_(bin) >= needed) {
+      cutoff_().bin = bin;
+      cutoff_().nabove = nabove;
+    }
+    nabove += bin_counts_(bin);
+  });
+}
+
+// The members of the cutoff bin are the candidates for the elites that are still needed
+template<class Runner>
+void Genetic<Runner>::narrow_cutoff() {
+  unsigned nbins = bin_counts_.extent(0);
+  Kokkos::parallel_for("narrow elite cutoff", RangePolicy(exec_, 0, 1), KOKKOS_CLASS_LAMBDA(unsigned) {
+    EliteCutoff& cutoff = cutoff_();
+    cutoff.ncandidates = cutoff.bin < nbins ? bin_counts_(cutoff.bin) : 0;
+    cutoff.needed -= cutoff.nabove;
+  });
+}
+
+// The lowest and highest keys of the candidates
+template<class Runner>
+void Genetic<Runner>::cutoff_bounds() {
+  unsigned popSize = ratings_.extent(0);
+  typedef Kokkos::MinMax<double, Kokkos::DefaultExecutionSpace::memory_space> KeyReducer;
+  Kokkos::parallel_reduce("elite cutoff bounds", RangePolicy(exec_, 0, popSize), KOKKOS_CLASS_LAMBDA(unsigned m, Kokkos::MinMaxScalar<double>& bounds) {
+    if(m >= cutoff_().ncandidates) return;
+    double key = get_cutoff_key(cutoff_members_(m));
+    bounds.min_val = Kokkos::min(bounds.min_val, key);
+    bounds.max_val = Kokkos::max(bounds.max_val, key);
+  }, KeyReducer(cutoff_bounds_));
+}
+
+// Orders the members of a bin the way is_better does, apart from its tie breaking
+// Finite crowding distances are at most one per objective, so an infinite one becomes just above that
+template<class Runner>
+double Genetic<Runner>::get_cutoff_key(unsigned i) const {
+  if(selection_ == PARETO_SELECTION) {
+    return crowding_(i) <= nobjectives_ ? crowding_(i) : nobjectives_+1;
+  }
+  return ratings_(i);
+}
+
+// Bins evenly divide the range of the candidates' keys
+template<class Runner>
+unsigned Genetic<Runner>::get_cutoff_bin(unsigned i) const {
+  unsigned nbins = bin_counts_.extent(0);
+  double width = cutoff_bounds_().max_val - cutoff_bounds_().min_val;
+  if(!(width > 0)) return 0;
+  unsigned bin = (get_cutoff_key(i) - cutoff_bounds_().min_val) / width * nbins;
+  return Kokkos::min(bin, nbins-1);
+}
+
+// Whether member i outranks member j
+// Ties are broken by index, except that the member found by the reduction always wins
+// With PARETO_SELECTION the earlier front wins, and then the larger crowding distance
+template<class Runner>
+bool Genetic<Runner>::is_better(unsigned i, unsigned j) const {
+  if(selection_ == PARETO_SELECTION) {
+    if(fronts_(i) != fronts_(j)) {
+      return fronts_(i) < fronts_(j);
+    }
+    if(crowding_(i) != crowding_(j)) {
+      return crowding_(i) > crowding_(j);
+    }
+  }
+  else if(ratings_(i) != ratings_(j)) {
+    return ratings_(i) > ratings_(j);
+  }
+  unsigned best = rating_bounds_().max_loc;
+  if(i == best) return j != best;
+  if(j == best) return false;
+  return i > j;
+}
+
+
+// Copies the best rating and the best member to the host
+// This is the only place the host waits for the device
+template<class Runner>
+auto Genetic<Runner>::pull_best() {
+  // The constexpr can't live inside the device lambda
+  if constexpr(current_population_.rank == 2) {
+    Kokkos::parallel_for("copy best member", RangePolicy(exec_, 0, best_member_.extent(0)), KOKKOS_CLASS_LAMBDA(unsigned i) {
+      best_member_(i) = current_population_(rating_bounds_().max_loc, i);
+    });
+  }
+  else {
+    Kokkos::parallel_for("copy best member", RangePolicy(exec_, 0, best_member_.extent(0)), KOKKOS_CLASS_LAMBDA(unsigned i) {
+      for(unsigned j=0; j<best_member_.extent(1); j++) {
+        best_member_(i,j) = current_population_(rating_bounds_().max_loc, i, j);
+      }
+    });
+  }
+  Kokkos::deep_copy(exec_, h_best_member_, best_member_);
+  Kokkos::deep_copy(exec_, h_rating_bounds_, rating_bounds_);
+  Kokkos::deep_copy(exec_, h_convergence_, convergence_);
+  exec_.fence();
+  return h_best_member_;
+}
+
+// Only valid after pull_best
+template<class Runner>
+double Genetic<Runner>::best_rating() const {
+  return h_rating_bounds_().max_val;
+}
+
+template<class Runner>
+auto Genetic<Runner>::pull_objectives() {
+  auto h_objectives = Kokkos::create_mirror_view(objectives_);
+  Kokkos::deep_copy(exec_, h_objectives, objectives_);
+  exec_.fence();
+  return h_objectives;
+}
+
+template<class Runner>
+auto Genetic<Runner>::pull_fronts() {
+  auto h_fronts = Kokkos::create_mirror_view(fronts_);
+  Kokkos::deep_copy(exec_, h_fronts, fronts_);
+  exec_.fence();
+  return h_fronts;
+}
+
+// The returned member is overwritten by the next call
+template<class Runner>
+auto Genetic<Runner>::pull_member(unsigned i) {
+  // The constexpr can't live inside the device lambda
+  if constexpr(current_population_.rank == 2) {
+    Kokkos::parallel_for("copy member", RangePolicy(exec_, 0, member_.extent(0)), KOKKOS_CLASS_LAMBDA(unsigned j) {
+      member_(j) = current_population_(i, j);
+    });
+  }
+  else {
+    Kokkos::parallel_for("copy member", RangePolicy(exec_, 0, member_.extent(0)), KOKKOS_CLASS_LAMBDA(unsigned j) {
+      for(unsigned k=0; k<member_.extent(1); k++) {
+        member_(j,k) = current_population_(i, j, k);
+      }
+    });
+  }
+  Kokkos::deep_copy(exec_, h_member_, member_);
+  exec_.fence();
+  return h_member_;
+}
+
+template<class Runner>
+unsigned Genetic<Runner>::member_size() const {
+  unsigned nentries = current_population_.extent(1);
+  if(current_population_.rank == 3) {
+    nentries *= current_population_.extent(2);
+  }
+  return nentries;
+}
+
+// Copies out the best members, best first
+template<class Runner>
+void Genetic<Runner>::get_migrants(Kokkos::View<GeneType**> members, Kokkos::View<double*> ratings) const {
+  unsigned popSize = current_population_.extent(0);
+  unsigned nmigrants = members.extent(0);
+
+  // The constexpr can't live inside the device lambda
+  if constexpr(current_population_.rank == 2) {
+    Kokkos::parallel_for("get migrants", RangePolicy(exec_, 0, nmigrants), KOKKOS_CLASS_LAMBDA(unsigned m) {
+      unsigned p = permutation_(popSize-1-m);
+      ratings(m) = ratings_(p);
+      for(unsigned j=0; j<current_population_.extent(1); j++) {
+        members(m,j) = current_population_(p,j);
+      }
+    });
   }
   else {
-    return Kokkos::subview(h_population, best_pop_subscript, Kokkos::ALL(), Kokkos::ALL());
+    Kokkos::parallel_for("get migrants", RangePolicy(exec_, 0, nmigrants), KOKKOS_CLASS_LAMBDA(unsigned m) {
+      unsigned p = permutation_(popSize-1-m);
+      unsigned nrooms = current_population_.extent(2);
+      ratings(m) = ratings_(p);
+      for(unsigned j=0; j<current_population_.extent(1); j++) {
+        for(unsigned k=0; k<nrooms; k++) {
+          members(m,j*nrooms+k) = current_population_(p,j,k);
+        }
+      }
+    });
+  }
+}
+
+// Replaces non-elite members with the migrants and finds the elites again
+// The migrants keep the ratings they had at home, but their rating states are rebuilt from scratch
+template<class Runner>
+void Genetic<Runner>::add_migrants(Kokkos::View<GeneType**> members, Kokkos::View<double*> ratings, unsigned eliteSize) {
+  unsigned popSize = current_population_.extent(0);
+  unsigned nmigrants = Kokkos::min(unsigned(members.extent(0)), popSize - eliteSize);
+
+  // The constexpr can't live inside the device lambda
+  if constexpr(current_population_.rank == 2) {
+    Kokkos::parallel_for("add migrants", RangePolicy(exec_, 0, nmigrants), KOKKOS_CLASS_LAMBDA(unsigned m) {
+      unsigned p = permutation_(m);
+      ratings_(p) = ratings(m);
+      current_nchanges_(p) = max_tracked_changes_+1;
+      for(unsigned j=0; j<current_population_.extent(1); j++) {
+        current_population_(p,j) = members(m,j);
+      }
+      index_member(p);
+    });
+  }
+  else {
+    Kokkos::parallel_for("add migrants", RangePolicy(exec_, 0, nmigrants), KOKKOS_CLASS_LAMBDA(unsigned m) {
+      unsigned p = permutation_(m);
+      unsigned nrooms = current_population_.extent(2);
+      ratings_(p) = ratings(m);
+      current_nchanges_(p) = max_tracked_changes_+1;
+      for(unsigned j=0; j<current_population_.extent(1); j++) {
+        for(unsigned k=0; k<nrooms; k++) {
+          current_population_(p,j,k) = members(m,j*nrooms+k);
+        }
+      }
+      index_member(p);
+    });
+  }
+  // The fronts need the migrants' objectives, which only come from rating them here
+  if(selection_ == PARETO_SELECTION) {
+    rate_population();
+  }
+  sort(eliteSize);
+}
+
+// Runs on the device so the host does not have to wait for the ratings every generation
+template<class Runner>
+void Genetic<Runner>::update_convergence() {
+  Kokkos::parallel_for("update convergence", RangePolicy(exec_, 0, 1), KOKKOS_CLASS_LAMBDA(unsigned) {
+    Convergence& convergence = convergence_();
+    if(convergence.reason != NOT_STOPPED) return;
+    const RatingBounds& bounds = rating_bounds_();
+    if(bounds.max_val > convergence.best_rating) {
+      convergence.best_rating = bounds.max_val;
+      convergence.stagnant_generations = 0;
+      convergence.mutation_scale = 1;
+    }
+    else {
+      convergence.stagnant_generations++;
+    }
+
+    if(bounds.max_val >= target_rating_) {
+      convergence.reason = TARGET_REACHED;
+    }
+    else if(bounds.max_val - bounds.min_val < diversity_threshold_) {
+      convergence.reason = CONVERGED;
+    }
+    else if(stagnation_limit_ > 0 && convergence.stagnant_generations >= stagnation_limit_) {
+      // Shake things up before giving up
+      double mutation_scale = convergence.mutation_scale * mutation_escalation_;
+      if(mutation_escalation_ > 1 && mutation_scale <= max_mutation_scale_) {
+        convergence.mutation_scale = mutation_scale;
+        convergence.stagnant_generations = 0;
+      }
+      else {
+        convergence.reason = STAGNATED;
+      }
+    }
+    Kokkos::atomic_store(&h_stop_reason_(), convergence.reason);
+  });
+}
+
+template<class Runner>
+const char* Genetic<Runner>::stop_reason(unsigned reason) const {
+  switch(reason) {
+    case TARGET_REACHED: return "reached the target rating";
+    case STAGNATED: return "stopped improving";
+    case CONVERGED: return "population converged";
+    case OUT_OF_TIME: return "ran out of time";
+    default: return "not stopped";
+  }
+}
+
+// The pool state can't be saved, so both generators are reseeded at every checkpoint, and a resumed run
+// reseeds them the same way; it resumes from the saved population, not the exact random stream
+// Checkpointing itself changes the stream compared with a run without checkpoints, and parallel backends
+// hand out pool states and break ties between equal ratings in whatever order the threads run
+template<class Runner>
+void Genetic<Runner>::reseed(unsigned generation) {
+  rng_.seed(seed_ + generation);
+  pool_ = Kokkos::Random_XorShift64_Pool<>(seed_ + generation);
+}
+
+template<class Runner>
+void Genetic<Runner>::write_checkpoint(unsigned generation) {
+  StageTimer stage_timer(*this, CHECKPOINT_STAGE);
+  static_assert(std::is_trivially_copyable_v<RatingState>, "Rating states are written as raw bytes");
+  unsigned popSize = current_population_.extent(0);
+
+  // The staging buffers are busy until the last checkpoint is on disk
+  if(checkpoint_writer_) {
+    checkpoint_writer_->wait();
+  }
+
+  // Stage the state on the host
+  // create_mirror_view would hand back the live views on a host backend, and the writer would then
+  // race with the next generations, so the staging buffers are always copies
+  if(h_checkpoint_ratings_.extent(0) != popSize) {
+    if constexpr(current_population_.rank == 2) {
+      checkpoint_population_ = CheckpointView("checkpoint population", popSize, current_population_.extent(1));
+    }
+    else {
+      checkpoint_population_ = CheckpointView("checkpoint population", popSize, current_population_.extent(1),
+                                              current_population_.extent(2));
+    }
+    h_checkpoint_population_ = Kokkos::create_mirror_view(checkpoint_population_);
+    h_checkpoint_ratings_ = Kokkos::create_mirror(ratings_);
+    h_checkpoint_states_ = Kokkos::create_mirror(current_states_);
+    h_checkpoint_probabilities_ = Kokkos::create_mirror(operator_probabilities_);
+    h_checkpoint_qualities_ = Kokkos::create_mirror(operator_qualities_);
+  }
+  Kokkos::deep_copy(exec_, checkpoint_population_, current_population_);
+  Kokkos::deep_copy(exec_, h_checkpoint_population_, checkpoint_population_);
+  Kokkos::deep_copy(exec_, h_checkpoint_ratings_, ratings_);
+  Kokkos::deep_copy(exec_, h_checkpoint_states_, current_states_);
+  Kokkos::deep_copy(exec_, h_checkpoint_probabilities_, operator_probabilities_);
+  Kokkos::deep_copy(exec_, h_checkpoint_qualities_, operator_qualities_);
+  Kokkos::deep_copy(exec_, h_convergence_, convergence_);
+  exec_.fence();
+
+  CheckpointHeader header{};
+  std::memcpy(header.magic, "GENETIC", 8);
+  header.version = checkpoint_version_;
+  header.generation = generation;
+  header.seed = seed_;
+  header.popSize = popSize;
+  header.member_size = member_size();
+  header.state_size = sizeof(RatingState);
+  header.gene_size = sizeof(GeneType);
+
+  reseed(generation);
+
+  // Write to a temporary file and rename it, so a job killed mid-write leaves the last checkpoint intact
+  checkpoint_writer_ = std::make_shared<std::future<void>>(std::async(std::launch::async, [header, convergence = h_convergence_(), filename = checkpoint_filename_,
+      population = h_checkpoint_population_, ratings = h_checkpoint_ratings_, states = h_checkpoint_states_,
+      probabilities = h_checkpoint_probabilities_, qualities = h_checkpoint_qualities_]() {
+    const char padding[8] = {0};
+    std::string tmp_filename = filename + ".tmp";
+    std::ofstream fout(tmp_filename, std::ios::binary);
+    fout.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    fout.write(reinterpret_cast<const char*>(&convergence), sizeof(convergence));
+    fout.write(reinterpret_cast<const char*>(ratings.data()), ratings.size()*sizeof(double));
+    size_t population_bytes = population.size()*sizeof(GeneType);
+    fout.write(reinterpret_cast<const char*>(population.data()), population_bytes);
+    fout.write(padding, (8 - population_bytes % 8) % 8);
+    size_t state_bytes = states.size()*sizeof(RatingState);
+    fout.write(reinterpret_cast<const char*>(states.data()), state_bytes);
+    fout.write(padding, (8 - state_bytes % 8) % 8);
+    fout.write(reinterpret_cast<const char*>(probabilities.data()), probabilities.size()*sizeof(double));
+    fout.write(reinterpret_cast<const char*>(qualities.data()), qualities.size()*sizeof(double));
+    fout.close();
+    if(!fout || std::rename(tmp_filename.c_str(), filename.c_str()) != 0) {
+      printf("Unable to write checkpoint %s\n", filename.c_str());
+    }
+  }));
+}
+
+// Returns false if there is no checkpoint to resume from
+template<class Runner>
+bool Genetic<Runner>::read_checkpoint(const std::string& filename, unsigned& generation) {
+  unsigned popSize = current_population_.extent(0);
+  std::ifstream fin(filename, std::ios::binary);
+  if(!fin) {
+    printf("No checkpoint %s; starting from scratch\n", filename.c_str());
+    return false;
+  }
+
+  CheckpointHeader header;
+  fin.read(reinterpret_cast<char*>(&header), sizeof(header));
+  if(!fin || std::memcmp(header.magic, "GENETIC", 8) != 0 || header.version != checkpoint_version_) {
+    Kokkos::abort("Not a checkpoint file, or one written by a different version");
+  }
+  if(header.popSize != popSize || header.member_size != member_size() || header.state_size != sizeof(RatingState) ||
+     header.gene_size != sizeof(GeneType)) {
+    Kokkos::abort("The checkpoint was written for a different problem or population size");
+  }
+
+  // Read into the staging buffers and copy them to the device
+  if constexpr(current_population_.rank == 2) {
+    checkpoint_population_ = CheckpointView("checkpoint population", popSize, current_population_.extent(1));
+  }
+  else {
+    checkpoint_population_ = CheckpointView("checkpoint population", popSize, current_population_.extent(1),
+                                            current_population_.extent(2));
+  }
+  h_checkpoint_population_ = Kokkos::create_mirror_view(checkpoint_population_);
+  h_checkpoint_ratings_ = Kokkos::create_mirror(ratings_);
+  h_checkpoint_states_ = Kokkos::create_mirror(current_states_);
+  h_checkpoint_probabilities_ = Kokkos::create_mirror(operator_probabilities_);
+  h_checkpoint_qualities_ = Kokkos::create_mirror(operator_qualities_);
+
+  char padding[8];
+  fin.read(reinterpret_cast<char*>(h_convergence_.data()), sizeof(Convergence));
+  size_t population_bytes = h_checkpoint_population_.size()*sizeof(GeneType);
+  fin.read(reinterpret_cast<char*>(h_checkpoint_ratings_.data()), h_checkpoint_ratings_.size()*sizeof(double));
+  fin.read(reinterpret_cast<char*>(h_checkpoint_population_.data()), population_bytes);
+  fin.read(padding, (8 - population_bytes % 8) % 8);
+  size_t state_bytes = h_checkpoint_states_.size()*sizeof(RatingState);
+  fin.read(reinterpret_cast<char*>(h_checkpoint_states_.data()), state_bytes);
+  fin.read(padding, (8 - state_bytes % 8) % 8);
+  fin.read(reinterpret_cast<char*>(h_checkpoint_probabilities_.data()), h_checkpoint_probabilities_.size()*sizeof(double));
+  fin.read(reinterpret_cast<char*>(h_checkpoint_qualities_.data()), h_checkpoint_qualities_.size()*sizeof(double));
+  if(!fin) {
+    Kokkos::abort("The checkpoint file is truncated");
+  }
+
+  Kokkos::deep_copy(exec_, checkpoint_population_, h_checkpoint_population_);
+  Kokkos::deep_copy(exec_, current_population_, checkpoint_population_);
+  Kokkos::deep_copy(exec_, ratings_, h_checkpoint_ratings_);
+  Kokkos::deep_copy(exec_, current_states_, h_checkpoint_states_);
+  Kokkos::deep_copy(exec_, operator_probabilities_, h_checkpoint_probabilities_);
+  Kokkos::deep_copy(exec_, operator_qualities_, h_checkpoint_qualities_);
+  Kokkos::deep_copy(exec_, convergence_, h_convergence_);
+  h_stop_reason_() = h_convergence_().reason;
+  // Everyone was rated right before the checkpoint
+  Kokkos::deep_copy(exec_, current_nchanges_, 0);
+  Kokkos::parallel_for("index population", RangePolicy(exec_, 0, popSize), KOKKOS_CLASS_LAMBDA(unsigned i) {
+    index_member(i);
+    store_objectives(i);
+  });
+  exec_.fence();
+
+  generation = header.generation;
+  seed_ = header.seed;
+  reseed(generation);
+  printf("Resuming from generation %u of %s\n", generation, filename.c_str());
+  return true;
+}
+
+// Kernels call this for every unit of work, but only touch the counters while profiling
+template<class Runner>
+void Genetic<Runner>::count_work(unsigned long long ProfileCounters::* counter, unsigned long long n) const {
+  if(profile_interval_ > 0 && n > 0) {
+    Kokkos::atomic_add(&(profile_counters_().*counter), n);
+  }
+}
+
+// Moves the current profile into the buffer at the end of every generation
+template<class Runner>
+void Genetic<Runner>::finish_profile() {
+  if(profile_interval_ == 0) return;
+
+  Kokkos::deep_copy(exec_, h_profile_counters_, profile_counters_);
+  Kokkos::deep_copy(exec_, profile_counters_, ProfileCounters{});
+  exec_.fence();
+  current_profile_.generation = profile_generation_;
+  current_profile_.counters = h_profile_counters_();
+  profiles_(nprofiles_++) = current_profile_;
+  current_profile_ = GenerationProfile{};
+
+  profile_generation_++;
+  if(profile_generation_ % profile_interval_ == 0 || nprofiles_ == profiles_.extent(0)) {
+    write_profile_summary();
+    nprofiles_ = 0;
+  }
+}
+
+// Averages the generations in the buffer
+template<class Runner>
+void Genetic<Runner>::write_profile_summary() const {
+  unsigned n = nprofiles_;
+  double seconds[NSTAGES] = {};
+  double total_seconds = 0;
+  ProfileCounters totals{};
+  for(unsigned i=0; i<n; i++) {
+    for(unsigned stage=0; stage<NSTAGES; stage++) {
+      seconds[stage] += profiles_(i).seconds[stage] / n;
+      total_seconds += profiles_(i).seconds[stage] / n;
+    }
+    totals.full_ratings += profiles_(i).counters.full_ratings;
+    totals.delta_ratings += profiles_(i).counters.delta_ratings;
+    totals.mutations += profiles_(i).counters.mutations;
+    totals.repair_steps += profiles_(i).counters.repair_steps;
+    totals.local_swaps += profiles_(i).counters.local_swaps;
+    totals.duplicates += profiles_(i).counters.duplicates;
+    totals.repairs += profiles_(i).counters.repairs;
+  }
+  unsigned first = profile_generation_ - n;
+  unsigned last = profile_generation_ - 1;
+  double rated_per_second = (totals.full_ratings + totals.delta_ratings) / (seconds[RATE_STAGE] * n);
+
+  printf("profile of generations %u-%u: %.3e seconds per generation\n", first, last, total_seconds);
+  for(unsigned stage=0; stage<NSTAGES; stage++) {
+    printf("  %-10s %.3e seconds (%.1f%%)\n", stage_name(stage), seconds[stage],
+           100 * seconds[stage] / total_seconds);
+  }
+  printf("  %.3e members rated per second, %.1f mutations, %.1f repair steps, %.1f local search swaps, "
+         "%.1f duplicates and %.1f repaired members per generation\n", rated_per_second,
+         double(totals.mutations) / n, double(totals.repair_steps) / n, double(totals.local_swaps) / n,
+         double(totals.duplicates) / n, double(totals.repairs) / n);
+
+  if(profile_filename_.empty()) return;
+  bool new_file = !std::ifstream(profile_filename_);
+  std::ofstream fout(profile_filename_, std::ios::app);
+  if(!fout) {
+    printf("Unable to write profile %s\n", profile_filename_.c_str());
+    return;
+  }
+  if(new_file) {
+    fout << "first_generation,last_generation";
+    for(unsigned stage=0; stage<NSTAGES; stage++) {
+      fout << "," << stage_name(stage) << "_seconds";
+    }
+    fout << ",full_ratings,delta_ratings,members_rated_per_second,mutations,repair_steps,local_swaps,duplicates,repairs\n";
+  }
+  fout << first << "," << last;
+  for(unsigned stage=0; stage<NSTAGES; stage++) {
+    fout << "," << seconds[stage];
+  }
+  fout << "," << double(totals.full_ratings) / n << "," << double(totals.delta_ratings) / n << ","
+       << rated_per_second << "," << double(totals.mutations) / n << "," << double(totals.repair_steps) / n << ","
+       << double(totals.local_swaps) / n << "," << double(totals.duplicates) / n << ","
+       << double(totals.repairs) / n << "\n";
+}
+
+template<class Runner>
+const char* Genetic<Runner>::stage_name(unsigned stage) {
+  switch(stage) {
+    case REPAIR_STAGE: return "repair";
+    case RATE_STAGE: return "rate";
+    case SORT_STAGE: return "sort";
+    case WEIGHTS_STAGE: return "weights";
+    case BREED_STAGE: return "breed";
+    case MUTATE_STAGE: return "mutate";
+    case SEARCH_STAGE: return "search";
+    case RECORD_STAGE: return "record";
+    case CHECKPOINT_STAGE: return "checkpoint";
+    default: return "unknown";
+  }
+}
+
+template<class Runner>
+Genetic<Runner>::StageTimer::StageTimer(Genetic& genetic, ProfileStage stage) :
+  genetic_(genetic), stage_(stage)
+{
+  Kokkos::Profiling::pushRegion(std::string("Genetic::") + stage_name(stage));
+}
+
+template<class Runner>
+Genetic<Runner>::StageTimer::~StageTimer() {
+  if(genetic_.profile_interval_ > 0) {
+    genetic_.exec_.fence();
+    genetic_.current_profile_.seconds[stage_] += timer_.seconds();
   }
+  Kokkos::Profiling::popRegion();
 }
 
-#endif /* GENETIC_H */
\ No newline at end of file
+#endif /* GENETIC_H */
@@ -0,0 +1,177 @@
+#ifndef ISLAND_H
+#define ISLAND_H
+
+#include "Genetic.hpp"
+#include <mpi.h>
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <vector>
+
+// Who sends migrants to whom
+enum MigrationTopology {
+  RING_TOPOLOGY,  // Each rank sends to the next one
+  RANDOM_TOPOLOGY // Each exchange sends around a ring in a random order
+};
+
+// Every MPI rank evolves its own population and periodically sends its best members to a neighbor
+// The exchange is started after ranking the population and finished after ranking the next one,
+// so the messages are in flight while the next generation is bred and rated
+template<class Runner>
+class Island {
+public:
+  Island(Genetic<Runner>& genetic, MPI_Comm comm=MPI_COMM_WORLD);
+  auto run(unsigned popSize, unsigned eliteSize, double mutationRate, unsigned generations);
+  void set_migration(unsigned migration_interval, unsigned nmigrants, MigrationTopology topology=RING_TOPOLOGY);
+  void set_report_interval(unsigned report_interval);
+private:
+  void start_migration(unsigned generation);
+  void finish_migration(unsigned eliteSize);
+  void report(unsigned generation);
+
+  typedef typename Genetic<Runner>::GeneType GeneType;
+
+  Genetic<Runner>& genetic_;
+  MPI_Comm comm_;
+  int rank_;
+  int nranks_;
+  unsigned migration_interval_{10};
+  unsigned nmigrants_{2};
+  MigrationTopology topology_{RING_TOPOLOGY};
+  unsigned report_interval_{100};
+  bool migrating_{false};
+  MPI_Request requests_[4];
+  Kokkos::View<GeneType**> send_members_;
+  Kokkos::View<double*> send_ratings_;
+  Kokkos::View<GeneType**> recv_members_;
+  Kokkos::View<double*> recv_ratings_;
+  typename Kokkos::View<GeneType**>::HostMirror h_send_members_;
+  Kokkos::View<double*>::HostMirror h_send_ratings_;
+  typename Kokkos::View<GeneType**>::HostMirror h_recv_members_;
+  Kokkos::View<double*>::HostMirror h_recv_ratings_;
+};
+
+// Every island gets its own seed, or they would all evolve the same population
+template<class Runner>
+Island<Runner>::Island(Genetic<Runner>& genetic, MPI_Comm comm) : genetic_(genetic), comm_(comm) {
+  MPI_Comm_rank(comm_, &rank_);
+  MPI_Comm_size(comm_, &nranks_);
+  genetic_.set_seed(5374857 + rank_);
+}
+
+template<class Runner>
+void Island<Runner>::set_migration(unsigned migration_interval, unsigned nmigrants, MigrationTopology topology) {
+  migration_interval_ = migration_interval;
+  nmigrants_ = nmigrants;
+  topology_ = topology;
+}
+
+template<class Runner>
+void Island<Runner>::set_report_interval(unsigned report_interval) {
+  report_interval_ = report_interval;
+}
+
+// Returns the best member found by any island on every rank
+template<class Runner>
+auto Island<Runner>::run(unsigned popSize, unsigned eliteSize, double mutationRate, unsigned generations) {
+  genetic_.initialize(popSize);
+
+  // Allocate the migration buffers
+  unsigned nmigrants = std::min(nmigrants_, popSize - eliteSize);
+  unsigned member_size = genetic_.member_size();
+  send_members_ = Kokkos::View<GeneType**>("send members", nmigrants, member_size);
+  send_ratings_ = Kokkos::View<double*>("send ratings", nmigrants);
+  recv_members_ = Kokkos::View<GeneType**>("recv members", nmigrants, member_size);
+  recv_ratings_ = Kokkos::View<double*>("recv ratings", nmigrants);
+  h_send_members_ = Kokkos::create_mirror_view(send_members_);
+  h_send_ratings_ = Kokkos::create_mirror_view(send_ratings_);
+  h_recv_members_ = Kokkos::create_mirror_view(recv_members_);
+  h_recv_ratings_ = Kokkos::create_mirror_view(recv_ratings_);
+
+  for(unsigned g=0; g<generations; g++) {
+    genetic_.rank_population(eliteSize);
+
+    if(migrating_) {
+      finish_migration(eliteSize);
+    }
+    if(nranks_ > 1 && nmigrants > 0 && g % migration_interval_ == 0) {
+      start_migration(g);
+    }
+    if(g % report_interval_ == 0) {
+      report(g);
+    }
+
+    genetic_.next_generation(eliteSize, mutationRate);
+  }
+
+  genetic_.rank_population(eliteSize);
+  if(migrating_) {
+    finish_migration(eliteSize);
+  }
+  report(generations);
+
+  // Send the best member of all islands to every rank
+  auto best_member = genetic_.pull_best();
+  struct {
+    double rating;
+    int rank;
+  } local_best{genetic_.best_rating(), rank_}, best;
+  MPI_Allreduce(&local_best, &best, 1, MPI_DOUBLE_INT, MPI_MAXLOC, comm_);
+  MPI_Bcast(best_member.data(), best_member.size()*sizeof(GeneType), MPI_BYTE, best.rank, comm_);
+
+  return best_member;
+}
+
+template<class Runner>
+void Island<Runner>::start_migration(unsigned generation) {
+  // Pick the neighbors
+  int dest = (rank_+1) % nranks_;
+  int source = (rank_+nranks_-1) % nranks_;
+  if(topology_ == RANDOM_TOPOLOGY) {
+    // Every rank draws the same order, so they agree on who talks to whom
+    std::vector<int> order(nranks_);
+    std::iota(order.begin(), order.end(), 0);
+    std::shuffle(order.begin(), order.end(), std::default_random_engine(generation));
+    int pos = std::find(order.begin(), order.end(), rank_) - order.begin();
+    dest = order[(pos+1) % nranks_];
+    source = order[(pos+nranks_-1) % nranks_];
+  }
+
+  // Stage the migrants on the host
+  genetic_.get_migrants(send_members_, send_ratings_);
+  Kokkos::deep_copy(h_send_members_, send_members_);
+  Kokkos::deep_copy(h_send_ratings_, send_ratings_);
+
+  // The genes are sent as raw bytes, whatever type the runner picked
+  int nbytes = h_send_members_.size()*sizeof(GeneType);
+  int nmigrants = h_send_ratings_.size();
+  MPI_Irecv(h_recv_members_.data(), nbytes, MPI_BYTE, source, 0, comm_, &requests_[0]);
+  MPI_Irecv(h_recv_ratings_.data(), nmigrants, MPI_DOUBLE, source, 1, comm_, &requests_[1]);
+  MPI_Isend(h_send_members_.data(), nbytes, MPI_BYTE, dest, 0, comm_, &requests_[2]);
+  MPI_Isend(h_send_ratings_.data(), nmigrants, MPI_DOUBLE, dest, 1, comm_, &requests_[3]);
+  migrating_ = true;
+}
+
+template<class Runner>
+void Island<Runner>::finish_migration(unsigned eliteSize) {
+  MPI_Waitall(4, requests_, MPI_STATUSES_IGNORE);
+  migrating_ = false;
+
+  Kokkos::deep_copy(recv_members_, h_recv_members_);
+  Kokkos::deep_copy(recv_ratings_, h_recv_ratings_);
+  genetic_.add_migrants(recv_members_, recv_ratings_, eliteSize);
+}
+
+// Prints the best rating of any island
+template<class Runner>
+void Island<Runner>::report(unsigned generation) {
+  genetic_.pull_best();
+  double local_best = genetic_.best_rating();
+  double best;
+  MPI_Reduce(&local_best, &best, 1, MPI_DOUBLE, MPI_MAX, 0, comm_);
+  if(rank_ == 0) {
+    printf("generation %u: %.17g\n", generation, best);
+  }
+}
+
+#endif /* ISLAND_H */
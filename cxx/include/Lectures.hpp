@@ -7,17 +7,29 @@
 class Lectures {
 public:
   Lectures(const std::string& filename);
+  void set_minisymposia(const Minisymposia& mini);
   KOKKOS_FUNCTION unsigned size() const;
-  KOKKOS_FUNCTION unsigned topic_cohesion_score(unsigned first, unsigned second) const;
-  KOKKOS_FUNCTION unsigned topic_cohesion_score(const Minisymposia& mini, unsigned mid, unsigned lid) const;
+  // The squared number of class codes two lectures (or a minisymposium and a lecture) share
+  KOKKOS_INLINE_FUNCTION unsigned topic_cohesion_score(unsigned first, unsigned second) const {
+    return lecture_scores_(first, second);
+  }
+  KOKKOS_INLINE_FUNCTION unsigned mini_cohesion_score(unsigned mid, unsigned lid) const {
+    return mini_scores_(lid, mid);
+  }
   const std::string& title(unsigned index) const;
   unsigned id(unsigned index) const;
   Kokkos::View<Theme*[3]>::HostMirror class_codes() const;
+  // Host copies of the score tables, indexed by lecture first
+  Kokkos::View<uint8_t**>::HostMirror lecture_scores() const;
+  Kokkos::View<uint8_t**>::HostMirror mini_scores() const;
 private:
   std::vector<unsigned> ids_;
   std::vector<std::string> titles_;
   std::vector<std::string> speakers_;
   Kokkos::View<Theme*[3]> class_codes_;
+  // The scores are computed once, since the mapper looks them up for every member it rates
+  Kokkos::View<uint8_t**> lecture_scores_;
+  Kokkos::View<uint8_t**> mini_scores_;
 };
 
 #endif /* LECTURES_H */
\ No newline at end of file
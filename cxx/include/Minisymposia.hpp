@@ -2,14 +2,62 @@
 #define MINISYMPOSIA_H
 
 #include "Minisymposium.hpp"
+#include "ProblemFile.hpp"
 #include "Rooms.hpp"
 #include "Theme.hpp"
 #include "Timeslots.hpp"
+#include "Utility.hpp"
 #include <Kokkos_Core.hpp>
 #include <ostream>
 #include <set>
 #include <vector>
 
+// The individual penalty terms of a schedule
+// Keeping them around lets us update a rating when only a few cells change
+struct Penalties {
+  unsigned order{0};
+  unsigned gumband_time{0};
+  unsigned gumband_room{0};
+  unsigned oversubscribed{0};
+  double theme{0};
+  unsigned timeslot{0};
+  unsigned room{0};
+  unsigned priority{0};
+
+  KOKKOS_INLINE_FUNCTION Penalties& operator+=(const Penalties& p) {
+    order += p.order;
+    gumband_time += p.gumband_time;
+    gumband_room += p.gumband_room;
+    oversubscribed += p.oversubscribed;
+    theme += p.theme;
+    timeslot += p.timeslot;
+    room += p.room;
+    priority += p.priority;
+    return *this;
+  }
+};
+
+// The objectives of a schedule, one per penalty term
+enum PenaltyTerm {
+  ORDER_TERM,
+  GUMBAND_TIME_TERM,
+  GUMBAND_ROOM_TERM,
+  OVERSUBSCRIBED_TERM,
+  THEME_TERM,
+  TIMESLOT_TERM,
+  ROOM_TERM,
+  PRIORITY_TERM,
+  NPENALTY_TERMS
+};
+
+// Lets Penalties be used as the result of a Kokkos reduction
+namespace Kokkos {
+template<>
+struct reduction_identity<Penalties> {
+  KOKKOS_FORCEINLINE_FUNCTION static Penalties sum() { return Penalties(); }
+};
+}
+
 class Minisymposia {
 public:
   Minisymposia(const std::string& filename);
@@ -18,14 +66,30 @@ public:
   ~Minisymposia() = default;
   Minisymposia& operator=(const Minisymposia&) = delete;
 
+  // A saved problem holds the parsed yaml and everything the constructor derives from it,
+  // so loading it skips both the parsing and the setup passes
+  static Minisymposia load(const std::string& filename);
+  void save(const std::string& filename, uint64_t key=0) const;
+
+  // Reads the problem from the yaml in directory, or from problem_file if it was saved from the same yaml
+  // Otherwise the problem is saved to problem_file, unless save_problem is false
+  static Minisymposia read(const std::string& directory, const std::string& problem_file,
+                           bool save_problem=true);
+
   unsigned find(unsigned mid) const;
   
   KOKKOS_FUNCTION unsigned size() const;
-  KOKKOS_FUNCTION const Minisymposium& operator[](unsigned i) const;
   const Minisymposium& get(unsigned i) const;
 
-  KOKKOS_FUNCTION bool overlaps_participants(unsigned m1, unsigned m2) const;
-  KOKKOS_FUNCTION bool breaks_ordering(unsigned m1, unsigned m2) const;
+  // The kernels only see these, never the Minisymposium objects
+  KOKKOS_INLINE_FUNCTION unsigned id(unsigned mid) const { return ids_(mid); }
+  KOKKOS_INLINE_FUNCTION unsigned priority(unsigned mid) const { return priorities_(mid); }
+  KOKKOS_INLINE_FUNCTION unsigned room_id(unsigned mid) const { return room_ids_(mid); }
+  KOKKOS_INLINE_FUNCTION unsigned nlectures(unsigned mid) const { return nlectures_(mid); }
+  KOKKOS_INLINE_FUNCTION bool is_multipart(unsigned mid) const { return is_multipart_(mid); }
+
+  KOKKOS_INLINE_FUNCTION const genetic::CsrMatrix<bool>& earlier_parts() const { return prereqs_; }
+  KOKKOS_INLINE_FUNCTION const genetic::CsrMatrix<bool>& later_parts() const { return is_prereq_; }
   unsigned get_max_penalty() const;
   void set_room_penalties(const Rooms& rooms);
   void set_overlapping_participants();
@@ -43,26 +107,66 @@ public:
   KOKKOS_FUNCTION const Timeslots& timeslots() const;
   KOKKOS_FUNCTION const Rooms& rooms() const;
 
-  template<class ViewType>
-  KOKKOS_INLINE_FUNCTION double rate_schedule(ViewType schedule, 
-    unsigned& order_penalty, unsigned& gumband_time_penalty, unsigned& gumband_room_penalty,
-    unsigned& oversubscribed_penalty, double& theme_penalty, unsigned& timeslot_penalty,
-    unsigned& room_penalty, unsigned& priority_penalty, bool verbose=false) const;
-  
-  template<class ViewType>
-  inline std::string rate_schedule(ViewType schedule) const;
+  template<class ViewType, class IndexType>
+  KOKKOS_INLINE_FUNCTION double rate_schedule(ViewType schedule, IndexType positions, Penalties& penalties) const;
+
+  template<class TeamMember, class ViewType, class IndexType>
+  KOKKOS_INLINE_FUNCTION double rate_schedule(const TeamMember& team, ViewType schedule, IndexType positions,
+    Penalties& penalties) const;
+
+  template<class ViewType, class IndexType, class ChangeView>
+  KOKKOS_INLINE_FUNCTION double update_penalties(ViewType schedule, IndexType positions, ChangeView changes,
+    unsigned nchanges, Penalties& penalties) const;
+
+  template<class ViewType, class IndexType>
+  KOKKOS_INLINE_FUNCTION double placement_penalty(ViewType schedule, IndexType positions, unsigned m1,
+    unsigned sl, unsigned r) const;
+
+  KOKKOS_INLINE_FUNCTION double score(const Penalties& penalties) const;
+
+  // Writes each term of penalties into terms(PenaltyTerm), scaled the way score scales it
+  template<class TermView>
+  KOKKOS_INLINE_FUNCTION void penalty_terms(const Penalties& penalties, TermView terms) const;
+  static const char* term_name(unsigned term);
+
+  // Describes every term of a schedule's penalties
+  std::string report(const Penalties& penalties) const;
 
   friend std::ostream& operator<<(std::ostream& os, const Minisymposia& mini);
 
   KOKKOS_INLINE_FUNCTION double get_nprereqs() const { return nprereqs_; }
 private:
+  Minisymposia(ProblemReader& problem);
+
+  template<class IndexType>
+  KOKKOS_INLINE_FUNCTION void add_related_penalties(IndexType positions, unsigned nrooms, unsigned m1,
+    Penalties& penalties) const;
+
+  template<class ViewType>
+  KOKKOS_INLINE_FUNCTION void add_cell_penalties(ViewType schedule, unsigned sl, unsigned r,
+    Penalties& penalties) const;
+
+  KOKKOS_INLINE_FUNCTION void finalize_penalties(Penalties& penalties) const;
+
+  void copy_to_device();
+
+  template<class ViewType, class IndexType, class ChangeView>
+  KOKKOS_INLINE_FUNCTION void update_cell_penalties(ViewType schedule, IndexType positions, unsigned sl, unsigned r,
+    ChangeView changes, unsigned nskip, Penalties& penalties, bool remove) const;
+
   Kokkos::View<Theme*[3]> class_codes_;
-  Kokkos::View<Minisymposium*> d_data_;
-  Kokkos::View<Minisymposium*>::HostMirror h_data_;
-  Kokkos::View<bool**> same_participants_;
-  Kokkos::View<bool**> is_prereq_;
-  Kokkos::View<double**> theme_penalties_;
-  Kokkos::View<bool**> valid_timeslots_;
+  // The strings and speakers stay on the host; the device gets a struct of arrays
+  Kokkos::View<Minisymposium*, Kokkos::HostSpace> h_data_;
+  Kokkos::View<unsigned*> ids_;
+  Kokkos::View<unsigned*> priorities_;
+  Kokkos::View<unsigned*> room_ids_;
+  Kokkos::View<unsigned*> nlectures_;
+  Kokkos::View<bool*> is_multipart_;
+  genetic::CsrMatrix<bool> same_participants_;
+  genetic::CsrMatrix<bool> is_prereq_;
+  genetic::CsrMatrix<bool> prereqs_;
+  genetic::CsrMatrix<double> theme_penalties_;
+  genetic::BitMatrix valid_timeslots_;
   Rooms rooms_;
   Timeslots timeslots_;
   unsigned nprereqs_;
@@ -71,170 +175,341 @@ private:
   unsigned max_priority_penalty_{0};
 };
 
-template<class ViewType>
+// Rates a schedule using positions(m), the flattened (slot,room) index of minisymposium m
+// The prerequisite and participant terms only visit related minisymposia
+template<class ViewType, class IndexType>
 KOKKOS_INLINE_FUNCTION 
-double Minisymposia::rate_schedule(ViewType schedule, 
-    unsigned& order_penalty, unsigned& gumband_time_penalty, unsigned& gumband_room_penalty,
-    unsigned& oversubscribed_penalty, double& theme_penalty, unsigned& timeslot_penalty,
-    unsigned& room_penalty, unsigned& priority_penalty, bool verbose) const
-{
+double Minisymposia::rate_schedule(ViewType schedule, IndexType positions, Penalties& penalties) const {
   unsigned nrooms = schedule.extent(1);
   unsigned nslots = schedule.extent(0);
   unsigned nmini = size();
-  // Compute the penalty related to multi-part minisymposia being out of order
-  // AMK 08.09.2023 Is this correct when they're in the same timeslot?
-  order_penalty = 0;
-  for(unsigned sl1=0; sl1<nslots; sl1++) {
-    for(unsigned r1=0; r1<nrooms; r1++) {
-      if(schedule(sl1,r1) >= nmini) continue;
-      for(unsigned sl2=sl1; sl2<nslots; sl2++) {
-        for(unsigned r2=0; r2<nrooms; r2++) {
-          if(schedule(sl2,r2) >= nmini) continue;
-          if(breaks_ordering(schedule(sl1,r1), schedule(sl2,r2))) {
-            if(verbose) {
-              auto m1 = schedule(sl1,r1);
-              auto m2 = schedule(sl2,r2);
-              printf("%i in slot %i and %i in slot %i are out of order\n", 
-                     d_data_(m1).id(), sl1, d_data_(m2).id(), sl2);
-            }
-            order_penalty++;
-          }
-        }
-      }
-    }
+
+  penalties = Penalties();
+  for(unsigned m1=0; m1<nmini; m1++) {
+    add_related_penalties(positions, nrooms, m1, penalties);
   }
-  // Compute the penalty related to multi-part minisymposia being too far away from each other
-  gumband_time_penalty = nprereqs_;
-  for(unsigned sl=0; sl<nslots-1; sl++) {
-    for(unsigned r1=0; r1<nrooms; r1++) {
-      unsigned m1 = schedule(sl,r1);
-      if(m1 >= nmini) continue;
-      for(unsigned r2=0; r2<nrooms; r2++) {
-        unsigned m2 = schedule(sl+1,r2);
-        if(m2 >= nmini) continue;
-        if(is_prereq_(m1, m2)) {
-          gumband_time_penalty--;
-        }
-      }
+  for(unsigned sl=0; sl<nslots; sl++) {
+    for(unsigned r=0; r<nrooms; r++) {
+      add_cell_penalties(schedule, sl, r, penalties);
     }
   }
-  // Compute the penalty related to multi-part minisymposia being in different rooms
-  gumband_room_penalty = nprereqs_;
-  for(unsigned sl1=0; sl1<nslots; sl1++) {
-    for(unsigned r=0; r<nrooms; r++) {
-      unsigned m1 = schedule(sl1, r);
-      if(m1 >= nmini) continue;
-      for(unsigned sl2=0; sl2<nslots; sl2++) {
-        unsigned m2 = schedule(sl2, r);
-        if(m2 >= nmini) continue;
-        if(is_prereq_(m1,m2)) {
-          gumband_room_penalty--;
-        }
-      }
+  finalize_penalties(penalties);
+
+  return score(penalties);
+}
+
+// Same as above, but the whole team cooperates on one schedule
+template<class TeamMember, class ViewType, class IndexType>
+KOKKOS_INLINE_FUNCTION 
+double Minisymposia::rate_schedule(const TeamMember& team, ViewType schedule, IndexType positions,
+  Penalties& penalties) const 
+{
+  unsigned nrooms = schedule.extent(1);
+  unsigned ncells = schedule.extent(0)*nrooms;
+  unsigned nmini = size();
+
+  Penalties related, cells;
+  Kokkos::parallel_reduce(Kokkos::TeamThreadRange(team, nmini), [&](unsigned m1, Penalties& lpenalties) {
+    add_related_penalties(positions, nrooms, m1, lpenalties);
+  }, related);
+  Kokkos::parallel_reduce(Kokkos::TeamThreadRange(team, ncells), [&](unsigned cell, Penalties& lpenalties) {
+    add_cell_penalties(schedule, cell / nrooms, cell % nrooms, lpenalties);
+  }, cells);
+  related += cells;
+  finalize_penalties(related);
+
+  Kokkos::single(Kokkos::PerTeam(team), [&]() {
+    penalties = related;
+  });
+  return score(related);
+}
+
+// Adds the terms that involve the earlier and later parts of m1 and the minisymposia it shares
+// participants with. The gumband terms count satisfied pairs until finalize_penalties is called.
+template<class IndexType>
+KOKKOS_INLINE_FUNCTION 
+void Minisymposia::add_related_penalties(IndexType positions, unsigned nrooms, unsigned m1,
+  Penalties& penalties) const
+{
+  unsigned sl1 = positions(m1) / nrooms;
+  unsigned r1 = positions(m1) % nrooms;
+
+  // Compute the penalty related to multi-part minisymposia being out of order
+  for(unsigned k=prereqs_.row_begin(m1); k<prereqs_.row_end(m1); k++) {
+    unsigned m2 = prereqs_.col(k);
+    if(positions(m2) / nrooms >= sl1) {
+      penalties.order++;
     }
   }
+
+  // Compute the penalty related to multi-part minisymposia being in different timeslots or rooms
+  for(unsigned k=is_prereq_.row_begin(m1); k<is_prereq_.row_end(m1); k++) {
+    unsigned m2 = is_prereq_.col(k);
+    unsigned sl2 = positions(m2) / nrooms;
+    unsigned r2 = positions(m2) % nrooms;
+    if(sl2 == sl1+1) penalties.gumband_time++;
+    if(r2 == r1) penalties.gumband_room++;
+  }
+
   // Compute the penalty related to oversubscribed participants
-  oversubscribed_penalty = 0;
-  for(unsigned sl=0; sl<nslots; sl++) {
-    for(unsigned r1=0; r1<nrooms; r1++) {
-      if(schedule(sl,r1) >= nmini) continue;
-      for(unsigned r2=r1+1; r2<nrooms; r2++) {
-        if(schedule(sl,r2) >= nmini) continue;
-        if(overlaps_participants(schedule(sl,r1), schedule(sl,r2))) {
-          if(verbose) {
-            printf("%i and %i share a participant in timeslot %i\n", 
-                   d_data_(schedule(sl,r1)).id(), d_data_(schedule(sl,r2)).id(), sl+1);
-          }
-          oversubscribed_penalty++;
-        }
-      }
+  for(unsigned k=same_participants_.row_begin(m1); k<same_participants_.row_end(m1); k++) {
+    unsigned m2 = same_participants_.col(k);
+    if(m2 > m1 && positions(m2) / nrooms == sl1) {
+      penalties.oversubscribed++;
     }
   }
+}
+
+// Adds the terms that only depend on cell (sl,r) and the cells after it in the same timeslot
+template<class ViewType>
+KOKKOS_INLINE_FUNCTION 
+void Minisymposia::add_cell_penalties(ViewType schedule, unsigned sl, unsigned r,
+  Penalties& penalties) const
+{
+  unsigned nrooms = schedule.extent(1);
+  unsigned nmini = size();
+  unsigned m1 = schedule(sl,r);
+  if(m1 >= nmini) return;
+
   // Compute the penalty related to theme overlap
-  theme_penalty = 0;
-  for(unsigned sl=0; sl<nslots; sl++) {
-    for(unsigned r=0; r<nrooms; r++) {
-      unsigned mini_index = schedule(sl,r);
-      if(mini_index >= nmini) continue;
-      for(unsigned r2=r+1; r2<nrooms; r2++) {
-        unsigned mini_index2 = schedule(sl,r2);
-        if(mini_index2 >= nmini) continue;
-        theme_penalty += theme_penalties_(r,r2);
-      }
+  if(theme_penalties_.degree(m1) > 0) {
+    for(unsigned r2=r+1; r2<nrooms; r2++) {
+      unsigned m2 = schedule(sl,r2);
+      if(m2 >= nmini) continue;
+      penalties.theme += theme_penalties_(m1, m2);
     }
   }
 
   // Compute the penalty related to scheduling speakers at a time they're not available
-  timeslot_penalty = 0;
-  for(unsigned sl=0; sl<nslots; sl++) {
-    for(unsigned r=0; r<nrooms; r++) {
-      unsigned mini_index = schedule(sl,r);
-      if(mini_index >= nmini) continue;
-      if(!valid_timeslots_(mini_index, sl)) {
-        if(verbose) printf("%i is in invalid timeslot %i\n", d_data_(mini_index).id(), sl+1);
-        timeslot_penalty++;
-      }
-    }
+  if(!valid_timeslots_(m1, sl)) {
+    penalties.timeslot++;
   }
 
   // Compute the penalty related to priority and room requests
-  room_penalty = 0;
-  priority_penalty = 0;
-  for(unsigned sl=0; sl<nslots; sl++) {
-    for(unsigned r=0; r<nrooms; r++) {
-      unsigned mini_index = schedule(sl,r);
-      if(mini_index >= nmini) continue;
-      unsigned room_id = d_data_[mini_index].room_id();
-      // This is a minisymposium with a room request
-      if(room_id < nrooms) {
-        if(room_id != r) {
-          if(verbose) printf("%i is in invalid room %i\n", d_data_(mini_index).id(), r);
-          room_penalty++;
-        }
-      }
-      // There is no room request
-      else {
-        unsigned priority = d_data_[mini_index].priority();
-        if(priority < r) {
-          priority_penalty += pow(r-priority, 2);
-        }
-      }
+  unsigned room_id = this->room_id(m1);
+  if(room_id < nrooms) {
+    if(room_id != r) {
+      penalties.room++;
     }
   }
-  double penalty = order_penalty + oversubscribed_penalty + room_penalty + timeslot_penalty;
-  penalty += theme_penalty + (gumband_time_penalty + gumband_room_penalty)/(double)nprereqs_ + map_priority_penalty(priority_penalty);
+  else {
+    unsigned priority = this->priority(m1);
+    if(priority < r) {
+      penalties.priority += pow(r-priority, 2);
+    }
+  }
+}
+
+// Turns the number of gumbanded pairs into the number of pairs that aren't
+KOKKOS_INLINE_FUNCTION 
+void Minisymposia::finalize_penalties(Penalties& penalties) const {
+  penalties.gumband_time = nprereqs_ - penalties.gumband_time;
+  penalties.gumband_room = nprereqs_ - penalties.gumband_room;
+}
+
+KOKKOS_INLINE_FUNCTION 
+double Minisymposia::score(const Penalties& penalties) const {
+  double penalty = penalties.order + penalties.oversubscribed + penalties.room + penalties.timeslot;
+  penalty += penalties.theme + (penalties.gumband_time + penalties.gumband_room)/(double)nprereqs_ 
+           + map_priority_penalty(penalties.priority);
   return 1 - penalty / max_penalty_;
 }
 
-template<class ViewType>
-inline std::string Minisymposia::rate_schedule(ViewType schedule) const {
-  Kokkos::View<unsigned*> d_penalties("penalties", 7);
-  Kokkos::View<double*> d_penalty("penalty", 1);
-  double score;
-  Kokkos::parallel_reduce("computing score", 1, KOKKOS_CLASS_LAMBDA (unsigned i, double& lscore) {
-    lscore = rate_schedule(schedule, d_penalties(0), d_penalties(1), d_penalties(2),
-      d_penalties(3), d_penalty(0), d_penalties(4), d_penalties(5), d_penalties(6));
-  }, score);
-
-  // Copy penalties back to device
-  auto h_penalties = Kokkos::create_mirror_view(d_penalties);
-  auto h_penalty = Kokkos::create_mirror_view(d_penalty);
-  Kokkos::deep_copy(h_penalties, d_penalties);
-  Kokkos::deep_copy(h_penalty, d_penalty);
-
-  std::ostringstream oss;
-
-  oss << "This schedule has score " << score 
-      << "\nThe penalty for multipart minisymposia being out of order is " << h_penalties(0)
-      << "\nThe penalty for multipart minisymposia not being in consecutive timeslots is " << h_penalties(1)
-      << "\nThe penalty for multipart minisymposia not being in the same room is " << h_penalties(2)
-      << "\nThe penalty for putting the same participant in two rooms at once is " << h_penalties(3)
-      << "\nThe penalty for putting too many minisymposia with the same themes in the same timeslot is " << h_penalty(0) 
-      << "\nThe penalty for putting a speaker in a timeslot they're not available is " << h_penalties(4)
-      << "\nThe penalty for putting a minisymposium in a room other than what they requested is " << h_penalties(5)
-      << "\nThe penalty for giving a minisymposium too small a room based on estimated popularity is " << h_penalties(2) 
-      << " in [ " << min_priority_penalty_ << ", " << max_priority_penalty_ << "]";
-  return oss.str();
+// The terms add up to the penalty score subtracts, so a schedule that is no worse in every term
+// is rated no lower
+template<class TermView>
+KOKKOS_INLINE_FUNCTION
+void Minisymposia::penalty_terms(const Penalties& penalties, TermView terms) const {
+  terms(ORDER_TERM) = penalties.order;
+  terms(GUMBAND_TIME_TERM) = penalties.gumband_time/(double)nprereqs_;
+  terms(GUMBAND_ROOM_TERM) = penalties.gumband_room/(double)nprereqs_;
+  terms(OVERSUBSCRIBED_TERM) = penalties.oversubscribed;
+  terms(THEME_TERM) = penalties.theme;
+  terms(TIMESLOT_TERM) = penalties.timeslot;
+  terms(ROOM_TERM) = penalties.room;
+  terms(PRIORITY_TERM) = map_priority_penalty(penalties.priority);
+}
+
+// Updates the penalties of a schedule that has been rated before
+// changes(i,0) is the flattened (slot,room) index of a modified cell and 
+// changes(i,1) is the value that cell held when penalties was computed
+// positions must already reflect the modified schedule
+template<class ViewType, class IndexType, class ChangeView>
+KOKKOS_INLINE_FUNCTION 
+double Minisymposia::update_penalties(ViewType schedule, IndexType positions, ChangeView changes,
+  unsigned nchanges, Penalties& penalties) const
+{
+  unsigned nrooms = schedule.extent(1);
+
+  // Temporarily restore the old values and remove their contributions
+  // Pairs of modified cells are only counted once
+  for(unsigned i=0; i<nchanges; i++) {
+    unsigned sl = changes(i,0) / nrooms, r = changes(i,0) % nrooms;
+    genetic::swap(schedule(sl,r), changes(i,1));
+  }
+  for(unsigned i=0; i<nchanges; i++) {
+    unsigned sl = changes(i,0) / nrooms, r = changes(i,0) % nrooms;
+    positions(schedule(sl,r)) = changes(i,0);
+  }
+  for(unsigned i=0; i<nchanges; i++) {
+    unsigned sl = changes(i,0) / nrooms, r = changes(i,0) % nrooms;
+    update_cell_penalties(schedule, positions, sl, r, changes, i, penalties, true);
+  }
+
+  // Put the new values back and add their contributions
+  for(unsigned i=0; i<nchanges; i++) {
+    unsigned sl = changes(i,0) / nrooms, r = changes(i,0) % nrooms;
+    genetic::swap(schedule(sl,r), changes(i,1));
+  }
+  for(unsigned i=0; i<nchanges; i++) {
+    unsigned sl = changes(i,0) / nrooms, r = changes(i,0) % nrooms;
+    positions(schedule(sl,r)) = changes(i,0);
+  }
+  for(unsigned i=0; i<nchanges; i++) {
+    unsigned sl = changes(i,0) / nrooms, r = changes(i,0) % nrooms;
+    update_cell_penalties(schedule, positions, sl, r, changes, i, penalties, false);
+  }
+
+  return score(penalties);
+}
+
+// How much putting m1 in the empty cell (sl,r) adds to the penalty of a partially built schedule
+// Cells holding nmini or more are empty, and minisymposia whose position is past the last cell
+// haven't been placed yet. The multi-part terms are left to the caller.
+template<class ViewType, class IndexType>
+KOKKOS_INLINE_FUNCTION 
+double Minisymposia::placement_penalty(ViewType schedule, IndexType positions, unsigned m1,
+  unsigned sl, unsigned r) const
+{
+  unsigned nrooms = schedule.extent(1);
+  unsigned ncells = schedule.extent(0)*nrooms;
+  unsigned nmini = size();
+  double penalty = 0;
+
+  if(!valid_timeslots_(m1, sl)) {
+    penalty++;
+  }
+  unsigned room_id = this->room_id(m1);
+  if(room_id < nrooms) {
+    if(room_id != r) {
+      penalty++;
+    }
+  }
+  else {
+    unsigned priority = this->priority(m1);
+    if(priority < r && max_priority_penalty_ > min_priority_penalty_) {
+      penalty += pow(r-priority, 2) / double(max_priority_penalty_ - min_priority_penalty_);
+    }
+  }
+
+  for(unsigned k=same_participants_.row_begin(m1); k<same_participants_.row_end(m1); k++) {
+    unsigned cell = positions(same_participants_.col(k));
+    if(cell < ncells && cell / nrooms == sl) {
+      penalty++;
+    }
+  }
+  if(theme_penalties_.degree(m1) > 0) {
+    for(unsigned r2=0; r2<nrooms; r2++) {
+      unsigned m2 = schedule(sl,r2);
+      if(r2 == r || m2 >= nmini) continue;
+      penalty += theme_penalties_(m1, m2);
+    }
+  }
+  return penalty;
+}
+
+// Adds (or removes) every penalty term that involves cell (sl,r)
+// Pairs with the first nskip cells in changes are ignored since they were already counted
+template<class ViewType, class IndexType, class ChangeView>
+KOKKOS_INLINE_FUNCTION 
+void Minisymposia::update_cell_penalties(ViewType schedule, IndexType positions, unsigned sl, unsigned r,
+  ChangeView changes, unsigned nskip, Penalties& penalties, bool remove) const
+{
+  unsigned nrooms = schedule.extent(1);
+  unsigned nmini = size();
+  unsigned m1 = schedule(sl,r);
+  if(m1 >= nmini) return;
+
+  auto skipped = [&](unsigned cell) {
+    for(unsigned i=0; i<nskip; i++) {
+      if(changes(i,0) == cell) return true;
+    }
+    return false;
+  };
+
+  Penalties local;
+
+  // Terms that only depend on this cell
+  if(!valid_timeslots_(m1, sl)) {
+    local.timeslot++;
+  }
+  unsigned room_id = this->room_id(m1);
+  if(room_id < nrooms) {
+    if(room_id != r) {
+      local.room++;
+    }
+  }
+  else {
+    unsigned priority = this->priority(m1);
+    if(priority < r) {
+      local.priority += pow(r-priority, 2);
+    }
+  }
+
+  // Terms that depend on the earlier and later parts of this minisymposium
+  // The gumband terms count satisfied pairs, which decrease the penalty
+  for(unsigned k=prereqs_.row_begin(m1); k<prereqs_.row_end(m1); k++) {
+    unsigned cell = positions(prereqs_.col(k));
+    if(skipped(cell)) continue;
+    unsigned sl2 = cell / nrooms, r2 = cell % nrooms;
+    if(sl2 >= sl) local.order++;
+    if(sl2+1 == sl) local.gumband_time++;
+    if(r2 == r) local.gumband_room++;
+  }
+  for(unsigned k=is_prereq_.row_begin(m1); k<is_prereq_.row_end(m1); k++) {
+    unsigned cell = positions(is_prereq_.col(k));
+    if(skipped(cell)) continue;
+    unsigned sl2 = cell / nrooms, r2 = cell % nrooms;
+    if(sl2 <= sl) local.order++;
+    if(sl2 == sl+1) local.gumband_time++;
+    if(r2 == r) local.gumband_room++;
+  }
+
+  // Terms that depend on the rest of this timeslot
+  for(unsigned k=same_participants_.row_begin(m1); k<same_participants_.row_end(m1); k++) {
+    unsigned cell = positions(same_participants_.col(k));
+    if(cell / nrooms != sl || skipped(cell)) continue;
+    local.oversubscribed++;
+  }
+  if(theme_penalties_.degree(m1) > 0) {
+    for(unsigned r2=0; r2<nrooms; r2++) {
+      if(r2 == r) continue;
+      unsigned m2 = schedule(sl,r2);
+      if(m2 >= nmini || skipped(sl*nrooms+r2)) continue;
+      local.theme += theme_penalties_(m1, m2);
+    }
+  }
+
+  if(remove) {
+    penalties.order -= local.order;
+    penalties.gumband_time += local.gumband_time;
+    penalties.gumband_room += local.gumband_room;
+    penalties.oversubscribed -= local.oversubscribed;
+    penalties.theme -= local.theme;
+    penalties.timeslot -= local.timeslot;
+    penalties.room -= local.room;
+    penalties.priority -= local.priority;
+  }
+  else {
+    penalties.order += local.order;
+    penalties.gumband_time -= local.gumband_time;
+    penalties.gumband_room -= local.gumband_room;
+    penalties.oversubscribed += local.oversubscribed;
+    penalties.theme += local.theme;
+    penalties.timeslot += local.timeslot;
+    penalties.room += local.room;
+    penalties.priority += local.priority;
+  }
 }
 
 #endif /* MINISYMPOSIA_H */
\ No newline at end of file
@@ -1,6 +1,7 @@
 #ifndef MINISYMPOSIUM_H
 #define MINISYMPOSIUM_H
 
+#include "ProblemFile.hpp"
 #include "Speaker.hpp"
 #include <Kokkos_Core.hpp>
 #include <ostream>
@@ -18,29 +19,33 @@ public:
                 const std::vector<Speaker>& speakers,
                 const std::string& room,
                 const std::vector<unsigned>& valid_timeslots);
+  Minisymposium(ProblemReader& problem);
   Minisymposium(const Minisymposium&) = default;
   ~Minisymposium() = default;
   Minisymposium& operator=(const Minisymposium&) = default;
 
   bool shares_participant(const Minisymposium& m) const;
   bool comes_before(const Minisymposium& m) const;
-  KOKKOS_FUNCTION unsigned priority() const;
+  unsigned priority() const;
   const std::string& short_title() const;
   const std::string& full_title() const;
   const std::string& room() const;
-  KOKKOS_FUNCTION unsigned id() const;
-  KOKKOS_FUNCTION unsigned room_id() const;
+  unsigned id() const;
+  unsigned room_id() const;
   unsigned total_citation_count() const;
   unsigned max_citation_count() const;
   const std::vector<std::string>& talks() const;
+  const std::vector<Speaker>& participants() const;
 
   void set_priority(unsigned priority);
   void set_room_id(unsigned id);
-  KOKKOS_FUNCTION unsigned size() const;
-  KOKKOS_FUNCTION bool is_multipart() const;
+  unsigned size() const;
+  bool is_multipart() const;
 
   bool is_valid_timeslot(unsigned timeslot) const;
 
+  void save(ProblemWriter& problem) const;
+
 private:
   bool is_multipart_;
   std::string title_with_part_, title_without_part_, room_;
@@ -0,0 +1,164 @@
+#ifndef PROBLEM_FILE_H
+#define PROBLEM_FILE_H
+
+#include "Kokkos_Core.hpp"
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+// A preprocessed problem is a header followed by a sequence of records
+// Strings, vectors and Views are stored as their extents followed by their data, and every record
+// is padded to 8 bytes so the arrays can be copied straight out of the memory-mapped file
+// The key identifies the inputs the problem was built from, so a stale file can be detected
+struct ProblemHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t reserved;
+  uint64_t key;
+};
+
+// A 64-bit FNV-1a hash of the contents of every file, in order
+uint64_t hash_files(const std::vector<std::string>& filenames);
+
+class ProblemWriter {
+public:
+  ProblemWriter(const std::string& filename, uint64_t key=0);
+  ProblemWriter(const ProblemWriter&) = delete;
+  ProblemWriter& operator=(const ProblemWriter&) = delete;
+  ~ProblemWriter();
+
+  template<class T>
+  void write(const T& value);
+  void write(const std::string& str);
+  template<class T>
+  void write(const std::vector<T>& vec);
+  template<class ViewType>
+  void write_view(const ViewType& view);
+
+  static constexpr uint32_t version_{2};
+private:
+  void write_bytes(const void* data, size_t nbytes);
+
+  std::string filename_;
+  std::ofstream fout_;
+};
+
+class ProblemReader {
+public:
+  ProblemReader(const std::string& filename);
+  ProblemReader(const ProblemReader&) = delete;
+  ProblemReader& operator=(const ProblemReader&) = delete;
+  ~ProblemReader();
+
+  // Whether filename is a problem file of this version built from the inputs with this key
+  static bool matches(const std::string& filename, uint64_t key);
+
+  template<class T>
+  T read();
+  std::string read_string();
+  template<class T>
+  std::vector<T> read_vector();
+  template<class ViewType>
+  ViewType read_view(const std::string& label);
+private:
+  const char* read_bytes(size_t nbytes);
+
+  std::string filename_;
+  const char* data_{nullptr};
+  size_t size_{0};
+  size_t offset_{0};
+};
+
+template<class T>
+void ProblemWriter::write(const T& value) {
+  static_assert(std::is_trivially_copyable_v<T>, "Only plain data can be written as raw bytes");
+  write_bytes(&value, sizeof(T));
+}
+
+template<class T>
+void ProblemWriter::write(const std::vector<T>& vec) {
+  write(uint64_t(vec.size()));
+  if constexpr(std::is_same_v<T, std::string>) {
+    for(const auto& str : vec) {
+      write(str);
+    }
+  }
+  else {
+    static_assert(std::is_trivially_copyable_v<T>, "Only plain data can be written as raw bytes");
+    write_bytes(vec.data(), vec.size()*sizeof(T));
+  }
+}
+
+// The view is copied to the host and written in its own layout
+template<class ViewType>
+void ProblemWriter::write_view(const ViewType& view) {
+  auto h_view = Kokkos::create_mirror_view_and_copy(Kokkos::HostSpace(), view);
+  for(unsigned i=0; i<ViewType::rank; i++) {
+    write(uint64_t(view.extent(i)));
+  }
+  write_bytes(h_view.data(), h_view.size()*sizeof(typename ViewType::value_type));
+}
+
+template<class T>
+T ProblemReader::read() {
+  static_assert(std::is_trivially_copyable_v<T>, "Only plain data can be read as raw bytes");
+  T value;
+  std::memcpy(&value, read_bytes(sizeof(T)), sizeof(T));
+  return value;
+}
+
+template<class T>
+std::vector<T> ProblemReader::read_vector() {
+  uint64_t n = read<uint64_t>();
+  std::vector<T> vec;
+  if constexpr(std::is_same_v<T, std::string>) {
+    vec.reserve(n);
+    for(uint64_t i=0; i<n; i++) {
+      vec.push_back(read_string());
+    }
+  }
+  else {
+    static_assert(std::is_trivially_copyable_v<T>, "Only plain data can be read as raw bytes");
+    const T* data = reinterpret_cast<const T*>(read_bytes(n*sizeof(T)));
+    vec.assign(data, data+n);
+  }
+  return vec;
+}
+
+// Allocates a view and fills it from the mapped file without staging it on the host first
+template<class ViewType>
+ViewType ProblemReader::read_view(const std::string& label) {
+  typedef typename ViewType::value_type value_type;
+  typedef Kokkos::View<typename ViewType::const_data_type, typename ViewType::array_layout, Kokkos::HostSpace,
+                       Kokkos::MemoryUnmanaged> MappedView;
+  static_assert(ViewType::rank <= 2, "Only 1D and 2D views are stored in problem files");
+
+  size_t extents[2] = {1, 1};
+  for(unsigned i=0; i<ViewType::rank; i++) {
+    extents[i] = read<uint64_t>();
+  }
+  const value_type* data = reinterpret_cast<const value_type*>(read_bytes(extents[0]*extents[1]*sizeof(value_type)));
+
+  ViewType view;
+  MappedView mapped;
+  if constexpr(ViewType::rank_dynamic == 1) {
+    view = ViewType(label, extents[0]);
+    mapped = MappedView(data, extents[0]);
+  }
+  else {
+    view = ViewType(label, extents[0], extents[1]);
+    mapped = MappedView(data, extents[0], extents[1]);
+  }
+  for(unsigned i=0; i<ViewType::rank; i++) {
+    if(view.extent(i) != extents[i]) {
+      Kokkos::abort("A view in the problem file has the wrong dimensions");
+    }
+  }
+  Kokkos::deep_copy(view, mapped);
+  return view;
+}
+
+#endif /* PROBLEM_FILE_H */
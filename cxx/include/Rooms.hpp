@@ -1,6 +1,7 @@
 #ifndef ROOMS_H
 #define ROOMS_H
 
+#include "ProblemFile.hpp"
 #include "Room.hpp"
 #include "Kokkos_Core.hpp"
 #include <string>
@@ -9,6 +10,8 @@ class Rooms {
 public:
   Rooms() = default;
   Rooms(const std::string& filename);
+  Rooms(ProblemReader& problem);
+  void save(ProblemWriter& problem) const;
   
   KOKKOS_FUNCTION unsigned size() const;
   const std::string& name(unsigned i) const;
@@ -3,7 +3,9 @@
 
 #include "Minisymposia.hpp"
 #include "Rooms.hpp"
+#include "Scheduler.hpp"
 #include <QAbstractTableModel>
+#include <QFutureWatcher>
 #include <QLineEdit>
 #include <QMainWindow>
 #include <QItemSelectionModel>
@@ -12,7 +14,7 @@
 class Schedule : public QAbstractTableModel
 {
 public:
-  Schedule(Kokkos::View<unsigned**,Kokkos::LayoutStride>::HostMirror mini_indices, const Minisymposia& mini, QObject *parent = nullptr);
+  Schedule(Kokkos::View<Scheduler::GeneType**,Kokkos::LayoutStride>::HostMirror mini_indices, const Minisymposia& mini, QObject *parent = nullptr);
   ~Schedule();
   int rowCount(const QModelIndex &parent = QModelIndex()) const override;
   int columnCount(const QModelIndex &parent = QModelIndex()) const override;
@@ -29,6 +31,11 @@ public:
   void computeScore();
   void search();
 private:
+  void swapCells(unsigned cell1, unsigned cell2);
+  void rescore();
+  void finishRescore();
+  void showScore();
+
   QMainWindow window_;
   QItemSelectionModel *selectionModel_;
   QTableView* tableView_;
@@ -37,6 +44,17 @@ private:
   Minisymposia mini_;
   Kokkos::View<unsigned**> d_mini_indices_;
   Kokkos::View<unsigned**>::HostMirror h_mini_indices_;
+  // positions(m) is the flattened (slot,room) index of minisymposium m
+  Kokkos::View<unsigned*> d_positions_;
+  Kokkos::View<unsigned*>::HostMirror h_positions_;
+  // Each edit updates the penalties of the schedule instead of rating it again
+  // Only the full rating after a load or a request for the score runs on the worker
+  Kokkos::View<Penalties> d_penalties_;
+  Penalties penalties_;
+  bool scored_{false};
+  bool stale_{false};
+  bool showReport_{false};
+  QFutureWatcher<Penalties> rescore_;
 };
 
 #endif // SCHEDULE_H
\ No newline at end of file
@@ -3,26 +3,68 @@
 
 #include "Minisymposia.hpp"
 #include "Rooms.hpp"
-#include "Schedule.hpp"
 #include "Utility.hpp"
 #include "Kokkos_Random.hpp"
 #include <fstream>
 #include <random>
 #include <vector>
-#include <QTableWidget>
+
+// How a mutation moves the gene in a cell
+// Every operator draws a fixed number of random numbers, so none of them can spin on bad draws
+enum MutationOperator {
+  ROOM_SWAP_MUTATION, // Swap with another room of the same timeslot, the requested one if there is one
+  SLOT_SWAP_MUTATION, // Swap into another valid timeslot, with a partner that is valid in this one
+  MOVE_MUTATION,      // Swap a minisymposium with an empty cell
+  BLOCK_MUTATION,     // Move every part of a multipart minisymposium to the same room
+  NMUTATION_OPERATORS
+};
 
 class Scheduler {
 public:
-  typedef Kokkos::View<unsigned***> ViewType;
+  // No conference has anywhere near 65536 cells
+  typedef uint16_t GeneType;
+  typedef Kokkos::View<GeneType***> ViewType;
+  typedef Penalties RatingState;
+  static constexpr unsigned nmutation_operators{NMUTATION_OPERATORS};
+  static constexpr unsigned nobjectives{NPENALTY_TERMS};
 
   Scheduler(const Minisymposia& mini);
   ViewType make_initial_population(unsigned nschedules) const;
 
-  template<class View2D>
-  KOKKOS_INLINE_FUNCTION double rate(View2D schedule, bool verbose=false) const;
+  template<class View2D, class View1D>
+  KOKKOS_INLINE_FUNCTION double rate(View2D schedule, View1D positions, RatingState& state, 
+                                     bool verbose=false) const;
 
-  template<class View2D>
-  KOKKOS_INLINE_FUNCTION void fix_order(View2D schedule, bool verbose=false) const;
+  template<class TeamMember, class View2D, class View1D>
+  KOKKOS_INLINE_FUNCTION double rate(const TeamMember& team, View2D schedule, View1D positions, 
+                                     RatingState& state) const;
+
+  // The penalty terms of a rated schedule, which are all to be minimized
+  template<class ObjectiveView>
+  KOKKOS_INLINE_FUNCTION void objectives(const RatingState& state, ObjectiveView objectives) const;
+  static const char* objective_name(unsigned objective);
+
+  template<class View2D, class View1D, class ChangeView>
+  KOKKOS_INLINE_FUNCTION double rate_delta(View2D schedule, View1D positions, ChangeView changes, 
+                                           unsigned nchanges, RatingState& state) const;
+
+  template<class View2D, class View1D>
+  KOKKOS_INLINE_FUNCTION double rate_swap(View2D schedule, View1D positions, unsigned cell1, unsigned cell2,
+                                          RatingState& state) const;
+
+  template<class View2D, class View1D, class Generator, class Recorder>
+  KOKKOS_INLINE_FUNCTION void mutate(unsigned op, View2D schedule, View1D positions, unsigned cell,
+                                     Generator& gen, Recorder record) const;
+
+  // The repair is a separate stage from rating, so it can be scheduled or skipped on its own
+  template<class View2D, class View1D>
+  KOKKOS_INLINE_FUNCTION void fix_order(View2D schedule, View1D positions, bool verbose=false) const;
+
+  template<class TeamMember, class View2D, class View1D>
+  KOKKOS_INLINE_FUNCTION void fix_order(const TeamMember& team, View2D schedule, View1D positions) const;
+
+  template<class View2D, class View1D, class Generator>
+  KOKKOS_INLINE_FUNCTION void greedy(View2D schedule, View1D positions, Generator& gen, bool randomize) const;
 
   template<class View2D>
   inline void record(const std::string& filename, View2D schedule) const;
@@ -33,137 +75,383 @@ public:
   void record(const std::string& filename) const;
 
 private:
+  template<class View2D, class View1D>
+  KOKKOS_INLINE_FUNCTION void swap_cells(View2D schedule, View1D positions, unsigned sl1, unsigned r1,
+                                         unsigned sl2, unsigned r2) const;
+
+  template<class View2D, class View1D>
+  KOKKOS_INLINE_FUNCTION void sort_rooms(View2D schedule, View1D positions, unsigned sl, bool verbose) const;
+
+  template<class View2D, class View1D>
+  KOKKOS_INLINE_FUNCTION void fix_parts(View2D schedule, View1D positions, bool verbose) const;
+
   Minisymposia mini_;
+  // The first part of every minisymposium, in the order greedy places them
+  Kokkos::View<unsigned*> heads_;
 };
 
-template<class View2D>
-double Scheduler::rate(View2D schedule, bool verbose) const {
-  fix_order(schedule, false);
-
-  unsigned order_penalty, gumband_time_penalty, gumband_room_penalty, oversubscribed_penalty;
-  double theme_penalty;
-  unsigned timeslot_penalty, room_penalty, priority_penalty;
-  double result = mini_.rate_schedule(schedule, order_penalty, gumband_time_penalty, gumband_room_penalty,
-                                      oversubscribed_penalty, theme_penalty, timeslot_penalty, room_penalty, 
-                                      priority_penalty, false);
+// positions(m) is the flattened (slot,room) index of minisymposium m in schedule
+template<class View2D, class View1D>
+double Scheduler::rate(View2D schedule, View1D positions, RatingState& state, bool verbose) const {
+  double result = mini_.rate_schedule(schedule, positions, state);
   if(verbose) {
     printf("%i,%i,%i,%i,%e,%e,%e,%e,", 
-    oversubscribed_penalty, 
-    room_penalty, 
-    timeslot_penalty, 
-    order_penalty,
-    mini_.map_priority_penalty(priority_penalty),
-    theme_penalty,
-    gumband_time_penalty/(double)mini_.get_nprereqs(), 
-    gumband_room_penalty/(double)mini_.get_nprereqs());
+    state.oversubscribed, 
+    state.room, 
+    state.timeslot, 
+    state.order,
+    mini_.map_priority_penalty(state.priority),
+    state.theme,
+    state.gumband_time/(double)mini_.get_nprereqs(), 
+    state.gumband_room/(double)mini_.get_nprereqs());
   }
   return result;
 }
 
-template<class View2D>
-void Scheduler::fix_order(View2D schedule, bool verbose) const {
+// The whole team shares the rating of one schedule
+template<class TeamMember, class View2D, class View1D>
+double Scheduler::rate(const TeamMember& team, View2D schedule, View1D positions, RatingState& state) const {
+  return mini_.rate_schedule(team, schedule, positions, state);
+}
+
+template<class ObjectiveView>
+void Scheduler::objectives(const RatingState& state, ObjectiveView objectives) const {
+  mini_.penalty_terms(state, objectives);
+}
+
+// Rates a schedule that was previously rated with state, given the cells that changed since
+// The changed cells are not repaired by fix_order
+template<class View2D, class View1D, class ChangeView>
+double Scheduler::rate_delta(View2D schedule, View1D positions, ChangeView changes, unsigned nchanges,
+                             RatingState& state) const {
+  return mini_.update_penalties(schedule, positions, changes, nchanges, state);
+}
+
+// Rates the schedule as if the genes in cell1 and cell2 were swapped, leaving the schedule alone
+// state holds the penalties of the schedule, and is updated to those of the swapped one
+template<class View2D, class View1D>
+double Scheduler::rate_swap(View2D schedule, View1D positions, unsigned cell1, unsigned cell2,
+                            RatingState& state) const {
+  using genetic::flat;
+  GeneType gene1 = flat(schedule, cell1), gene2 = flat(schedule, cell2);
+  genetic::SwappedCells<View2D> swapped(schedule, cell1, cell2);
+  genetic::SwappedPositions<View1D> swapped_positions(positions, gene1, gene2);
+  genetic::SwapChanges<GeneType> changes{{{GeneType(cell1), gene1}, {GeneType(cell2), gene2}}};
+  return mini_.update_penalties(swapped, swapped_positions, changes, 2, state);
+}
+
+// Applies mutation operator op to the gene in cell, calling record(c) before cell c changes
+// An operator that doesn't apply to the gene falls back to one that does
+template<class View2D, class View1D, class Generator, class Recorder>
+void Scheduler::mutate(unsigned op, View2D schedule, View1D positions, unsigned cell, Generator& gen,
+                       Recorder record) const {
   unsigned nmini = mini_.size();
+  unsigned ncells = nslots()*nrooms();
+  unsigned sl = cell / nrooms(), r = cell % nrooms();
+  unsigned m = schedule(sl,r);
+  bool is_empty = m >= nmini;
+  bool has_room = !is_empty && mini_.room_id(m) < nrooms();
 
-  // Sort the minisymposia in each slot based on the room priority
-  // Assign minisymposia to the correct rooms if possible
-  for(unsigned sl=0; sl<nslots(); sl++) {
+  auto swap = [&](unsigned sl1, unsigned r1, unsigned sl2, unsigned r2) {
+    if(sl1 == sl2 && r1 == r2) return;
+    record(sl1*nrooms()+r1);
+    record(sl2*nrooms()+r2);
+    swap_cells(schedule, positions, sl1, r1, sl2, r2);
+  };
+  // Any room but r, unless there is only one
+  auto other_room = [&]() {
+    if(nrooms() < 2) return r;
+    unsigned r2 = gen.rand(nrooms()-1);
+    return r2 < r ? r2 : r2+1;
+  };
+  auto is_part = [&](unsigned m2) {
+    return m2 == m || mini_.earlier_parts()(m, m2) || mini_.later_parts()(m, m2);
+  };
+
+  // A minisymposium already in its requested room changes timeslots instead
+  if(op == ROOM_SWAP_MUTATION && has_room && mini_.room_id(m) == r) {
+    op = SLOT_SWAP_MUTATION;
+  }
+  if(op == BLOCK_MUTATION && (is_empty || !mini_.is_multipart(m))) {
+    op = SLOT_SWAP_MUTATION;
+  }
+  if(op == MOVE_MUTATION && ncells == nmini) {
+    op = SLOT_SWAP_MUTATION;
+  }
+
+  if(op == ROOM_SWAP_MUTATION) {
+    swap(sl, r, sl, has_room ? mini_.room_id(m) : other_room());
+  }
+  else if(op == SLOT_SWAP_MUTATION) {
+    // Draw one of the other timeslots this gene can go in
+    unsigned nvalid = 0;
+    for(unsigned sl2=0; sl2<nslots(); sl2++) {
+      if(sl2 != sl && (is_empty || mini_.is_valid_timeslot(m, sl2))) nvalid++;
+    }
+    if(nvalid == 0) return;
+    unsigned k = gen.rand(nvalid);
+    unsigned sl2 = 0;
+    for(; sl2<nslots(); sl2++) {
+      if(sl2 != sl && (is_empty || mini_.is_valid_timeslot(m, sl2)) && k-- == 0) break;
+    }
+    // The partner moves to this timeslot, so it has to be valid here too
+    unsigned r2 = has_room ? mini_.room_id(m) : gen.rand(nrooms());
     for(unsigned i=0; i<nrooms(); i++) {
-      auto m1 = schedule(sl,i);
-      unsigned min_index = i;
-      unsigned min_value = unsigned(-1);
-      if(m1 < nmini) {
-        if(mini_[m1].room_id() == i) {
-          if(verbose) {
-//            printf("Minisymposium %i is already in the correct room\n", m1);
-          }
-          continue;
-        }
-        min_value = mini_[m1].priority();
+      unsigned m2 = schedule(sl2, (r2+i) % nrooms());
+      if(m2 >= nmini || mini_.is_valid_timeslot(m2, sl)) {
+        swap(sl, r, sl2, (r2+i) % nrooms());
+        return;
       }
-      for(unsigned j=i+1; j<nrooms(); j++) {
-        auto m2 = schedule(sl,j);
-        if(m2 >= nmini) continue;
-        // If this item is supposed to be in room i, put it there
-        if(mini_[m2].room_id() == i) {
-          if(verbose) {
-            printf("assigning %i at position %i to room %i as requested\n", m2, j, i);
-          }
-          min_index = j;
-          min_value = 0;
-          break;
-        }
-        if(mini_[m2].priority() < min_value) {
-          min_index = j;
-          min_value = mini_[m2].priority();
-        }
+    }
+  }
+  else if(op == MOVE_MUTATION) {
+    // The empty genes are nmini and up, so drawing one finds an empty cell right away
+    // An empty cell pulls in a random minisymposium instead
+    unsigned gene = is_empty ? gen.rand(nmini) : nmini + gen.rand(ncells-nmini);
+    unsigned cell2 = positions(gene);
+    swap(sl, r, cell2 / nrooms(), cell2 % nrooms());
+  }
+  else if(op == BLOCK_MUTATION) {
+    // Each part keeps its timeslot, and whatever was in the room trades places with it
+    unsigned r2 = has_room && mini_.room_id(m) != r ? mini_.room_id(m) : other_room();
+    swap(sl, r, sl, r2);
+    for(unsigned pass=0; pass<2; pass++) {
+      const auto& parts = pass == 0 ? mini_.earlier_parts() : mini_.later_parts();
+      for(unsigned k=parts.row_begin(m); k<parts.row_end(m); k++) {
+        unsigned sl2 = positions(parts.col(k)) / nrooms();
+        unsigned m2 = schedule(sl2, r2);
+        if(m2 < nmini && is_part(m2)) continue;
+        swap(sl2, positions(parts.col(k)) % nrooms(), sl2, r2);
       }
-      if(min_index != i) {
-        genetic::swap(schedule(sl,i), schedule(sl, min_index));
+    }
+  }
+}
+
+template<class View2D, class View1D>
+void Scheduler::swap_cells(View2D schedule, View1D positions, unsigned sl1, unsigned r1,
+                           unsigned sl2, unsigned r2) const {
+  genetic::swap(schedule(sl1,r1), schedule(sl2,r2));
+  positions(schedule(sl1,r1)) = sl1*nrooms()+r1;
+  positions(schedule(sl2,r2)) = sl2*nrooms()+r2;
+}
+
+// Repairs what crossover and mutation broke: the rooms within each slot, then the multi-part minisymposia
+template<class View2D, class View1D>
+void Scheduler::fix_order(View2D schedule, View1D positions, bool verbose) const {
+  for(unsigned sl=0; sl<nslots(); sl++) {
+    sort_rooms(schedule, positions, sl, verbose);
+  }
+  fix_parts(schedule, positions, verbose);
+}
+
+// Each slot only swaps its own cells, so the team sorts the slots in parallel
+// The multi-part passes move minisymposia between slots, and each move depends on the ones before it
+template<class TeamMember, class View2D, class View1D>
+void Scheduler::fix_order(const TeamMember& team, View2D schedule, View1D positions) const {
+  Kokkos::parallel_for(Kokkos::TeamThreadRange(team, nslots()), [&](unsigned sl) {
+    sort_rooms(schedule, positions, sl, false);
+  });
+  team.team_barrier();
+  Kokkos::single(Kokkos::PerTeam(team), [&]() {
+    fix_parts(schedule, positions, false);
+  });
+  team.team_barrier();
+}
+
+// Sort the minisymposia in slot sl based on the room priority
+// Assign minisymposia to the correct rooms if possible
+template<class View2D, class View1D>
+void Scheduler::sort_rooms(View2D schedule, View1D positions, unsigned sl, bool verbose) const {
+  unsigned nmini = mini_.size();
+  for(unsigned i=0; i<nrooms(); i++) {
+    auto m1 = schedule(sl,i);
+    unsigned min_index = i;
+    unsigned min_value = unsigned(-1);
+    if(m1 < nmini) {
+      if(mini_.room_id(m1) == i) {
+        continue;
       }
-      if(verbose) {
-        auto mid = schedule(sl,i);
-        if(mid < nmini) {
-          unsigned priority = mini_[mid].priority();
-          unsigned rid = mini_[mid].room_id();
-//          printf("schedule(%i,%i) = %i with priority %i and room id %i\n", sl, i, mid, priority, rid);
-        }
-        else {
-//          printf("schedule(%i,%i) = %i\n", sl, i, mid);
+      min_value = mini_.priority(m1);
+    }
+    for(unsigned j=i+1; j<nrooms(); j++) {
+      auto m2 = schedule(sl,j);
+      if(m2 >= nmini) continue;
+      // If this item is supposed to be in room i, put it there
+      if(mini_.room_id(m2) == i) {
+        if(verbose) {
+          printf("assigning %i at position %i to room %i as requested\n", m2, j, i);
         }
+        min_index = j;
+        min_value = 0;
+        break;
+      }
+      if(mini_.priority(m2) < min_value) {
+        min_index = j;
+        min_value = mini_.priority(m2);
       }
     }
+    if(min_index != i) {
+      swap_cells(schedule, positions, sl, i, sl, min_index);
+    }
   }
+}
+
+// Moves the parts of multi-part minisymposia next to each other and into order
+template<class View2D, class View1D>
+void Scheduler::fix_parts(View2D schedule, View1D positions, bool verbose) const {
+  unsigned nmini = mini_.size();
+  const auto& earlier_parts = mini_.earlier_parts();
+  const auto& later_parts = mini_.later_parts();
 
   // If we can gumband multi-part minisymposia together, do that
-  for(unsigned sl1=0; sl1<nslots(); sl1++) {
+  // Only the other parts of a minisymposium need to be considered
+  for(unsigned sl1=0; sl1+1<nslots(); sl1++) {
     for(unsigned r1=0; r1<nrooms(); r1++) {
       unsigned m1 = schedule(sl1,r1);
       if(m1 >= nmini) continue;
-      if(!mini_[m1].is_multipart()) continue;
-      for(unsigned sl2=sl1+1; sl2<nslots(); sl2++) {
-        for(unsigned r2=0; r2<nrooms(); r2++) {
-          unsigned m2 = schedule(sl2,r2);
-          if(m2 >= nmini) continue;
-          // Ignore minisymposia that don't have multiple parts
-          // They can't have this problem
-          if(!mini_[m2].is_multipart()) continue;
-          
+      if(!mini_.is_multipart(m1)) continue;
+      for(unsigned pass=0; pass<2; pass++) {
+        const auto& parts = pass == 0 ? earlier_parts : later_parts;
+        for(unsigned k=parts.row_begin(m1); k<parts.row_end(m1); k++) {
+          unsigned m2 = parts.col(k);
+          unsigned sl2 = positions(m2) / nrooms();
+          unsigned r2 = positions(m2) % nrooms();
+          if(sl2 <= sl1) continue;
+
           // If the slot after the first is not valid for the second minisymposium,
           // don't even think about gumbanding it (and vice versa)
           if(!mini_.is_valid_timeslot(m2, sl1+1)) continue;
           unsigned ms1p1 = schedule(sl1+1, r1);
           if(ms1p1 < nmini && !mini_.is_valid_timeslot(ms1p1, sl2)) continue;
 
-          if(mini_.breaks_ordering(m2, m1) || mini_.breaks_ordering(m1, m2)) {
-            // swap the second minisymposium with whatever comes after the first
-            genetic::swap(schedule(sl2, r2), schedule(sl1+1, r1));
-          }
+          // swap the second minisymposium with whatever comes after the first
+          swap_cells(schedule, positions, sl2, r2, sl1+1, r1);
         }
       }
     }
   }
 
   // If we can put multi-part minisymposia in order, do that
+  // Keep pulling earlier parts into this cell until none of them are scheduled later
   for(unsigned sl1=0; sl1<nslots(); sl1++) {
     for(unsigned r1=0; r1<nrooms(); r1++) {
-      if(schedule(sl1,r1) >= nmini) continue;
-      for(unsigned sl2=sl1+1; sl2<nslots(); sl2++) {
-        for(unsigned r2=0; r2<nrooms(); r2++) {
-          if(schedule(sl2,r2) >= nmini) continue;
-          if(mini_.breaks_ordering(schedule(sl1,r1), schedule(sl2,r2))) {
-            if(verbose) {
-              printf("swapping s(%i,%i)=%i and s(%i,%i)=%i as requested\n", 
-                     sl1, r1, schedule(sl1, r1), sl2, r2, schedule(sl2, r2));
-            }
-            // swap the values
-            genetic::swap(schedule(sl1, r1), schedule(sl2, r2));
+      bool swapped = true;
+      while(swapped) {
+        swapped = false;
+        unsigned m1 = schedule(sl1,r1);
+        if(m1 >= nmini) break;
+        for(unsigned k=earlier_parts.row_begin(m1); k<earlier_parts.row_end(m1); k++) {
+          unsigned m2 = earlier_parts.col(k);
+          unsigned sl2 = positions(m2) / nrooms();
+          unsigned r2 = positions(m2) % nrooms();
+          if(sl2 <= sl1) continue;
+          if(verbose) {
+            printf("swapping s(%i,%i)=%i and s(%i,%i)=%i as requested\n", 
+                   sl1, r1, m1, sl2, r2, m2);
           }
+          swap_cells(schedule, positions, sl1, r1, sl2, r2);
+          swapped = true;
+          break;
         }
       }
     }
   }
 }
 
+// Builds a schedule one minisymposium at a time, in the order of heads_
+// All parts of a minisymposium go in the same room in consecutive timeslots if there's space for them,
+// in whichever free cells add the least penalty. Ties go to a random cell if randomize is set.
+template<class View2D, class View1D, class Generator>
+void Scheduler::greedy(View2D schedule, View1D positions, Generator& gen, bool randomize) const {
+  unsigned nmini = mini_.size();
+  unsigned ncells = nslots()*nrooms();
+  const auto& earlier_parts = mini_.earlier_parts();
+  const auto& later_parts = mini_.later_parts();
+
+  // Everything starts out empty
+  for(unsigned sl=0; sl<nslots(); sl++) {
+    for(unsigned r=0; r<nrooms(); r++) {
+      schedule(sl,r) = ncells;
+    }
+  }
+  for(unsigned m=0; m<nmini; m++) {
+    positions(m) = ncells;
+  }
+
+  double best_penalty;
+  unsigned best_cell, nties;
+  auto consider = [&](unsigned cell, double penalty) {
+    if(best_cell < ncells && penalty > best_penalty) return;
+    if(best_cell == ncells || penalty < best_penalty) {
+      best_penalty = penalty;
+      best_cell = cell;
+      nties = 1;
+      return;
+    }
+    nties++;
+    if(randomize && gen.rand(nties) == 0) {
+      best_cell = cell;
+    }
+  };
+  auto place = [&](unsigned m, unsigned cell) {
+    schedule(cell / nrooms(), cell % nrooms()) = m;
+    positions(m) = cell;
+  };
+
+  for(unsigned h=0; h<heads_.extent(0); h++) {
+    unsigned m1 = heads_(h);
+
+    // Part m2 goes earlier_parts.degree(m2) slots after the first one
+    best_cell = ncells;
+    for(unsigned sl=0; sl<nslots(); sl++) {
+      for(unsigned r=0; r<nrooms(); r++) {
+        if(schedule(sl,r) < ncells) continue;
+        double penalty = mini_.placement_penalty(schedule, positions, m1, sl, r);
+        bool fits = true;
+        for(unsigned k=later_parts.row_begin(m1); k<later_parts.row_end(m1); k++) {
+          unsigned m2 = later_parts.col(k);
+          unsigned sl2 = sl + earlier_parts.degree(m2);
+          if(sl2 >= nslots() || schedule(sl2,r) < ncells) {
+            fits = false;
+            break;
+          }
+          penalty += mini_.placement_penalty(schedule, positions, m2, sl2, r);
+        }
+        if(fits) consider(sl*nrooms()+r, penalty);
+      }
+    }
+    if(best_cell < ncells) {
+      place(m1, best_cell);
+      for(unsigned k=later_parts.row_begin(m1); k<later_parts.row_end(m1); k++) {
+        unsigned m2 = later_parts.col(k);
+        place(m2, best_cell + earlier_parts.degree(m2)*nrooms());
+      }
+      continue;
+    }
+
+    // There is no room for all the parts together, so each one gets the best free cell
+    // There are at least as many cells as minisymposia, so there is always one
+    for(unsigned k=later_parts.row_begin(m1); k<=later_parts.row_end(m1); k++) {
+      unsigned m2 = k < later_parts.row_end(m1) ? later_parts.col(k) : m1;
+      best_cell = ncells;
+      for(unsigned cell=0; cell<ncells; cell++) {
+        unsigned sl = cell / nrooms(), r = cell % nrooms();
+        if(schedule(sl,r) < ncells) continue;
+        consider(cell, mini_.placement_penalty(schedule, positions, m2, sl, r));
+      }
+      place(m2, best_cell);
+    }
+  }
+
+  // The empty cells get the remaining genes
+  for(unsigned cell=0, empty_val=nmini; cell<ncells; cell++) {
+    if(schedule(cell / nrooms(), cell % nrooms()) == ncells) {
+      place(empty_val, cell);
+      empty_val++;
+    }
+  }
+}
+
 template<class View2D>
 void Scheduler::record(const std::string& filename, View2D schedule) const {
   unsigned nmini = mini_.size();
@@ -3,7 +3,9 @@
 
 #include<string>
 #include<unordered_map>
+#include<vector>
 
+// Speakers are interned, so comparing two of them compares integers rather than names
 class Speaker {
 public:
   Speaker() = default;
@@ -16,13 +18,22 @@ public:
   bool operator<(const Speaker& speaker) const;
 
   bool empty() const;
+  // Stand-ins like TBD don't make two minisymposia share a participant
+  bool is_placeholder() const;
+  unsigned id() const;
   const std::string& name() const;
   unsigned citations() const;
 
+  static unsigned count();
   static void read(const std::string& filename);
 private:
-  std::string name_;
-  static std::unordered_map<std::string, unsigned> citation_map_;
+  static unsigned intern(const std::string& name);
+
+  // Speaker 0 is the empty name
+  unsigned id_{0};
+  static std::unordered_map<std::string, unsigned> id_map_;
+  static std::vector<std::string> names_;
+  static std::vector<unsigned> citations_;
 };
 
-#endif /* SPEAKER_H */
\ No newline at end of file
+#endif /* SPEAKER_H */
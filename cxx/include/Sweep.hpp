@@ -0,0 +1,135 @@
+#ifndef SWEEP_H
+#define SWEEP_H
+
+#include "Genetic.hpp"
+#include <cstdio>
+#include <type_traits>
+#include <vector>
+
+// One set of hyperparameters in a sweep
+struct SweepConfig {
+  unsigned popSize;
+  unsigned eliteSize;
+  double mutationRate;
+  unsigned seed;
+};
+
+// Evolves one population per configuration, side by side on the same device
+// The runner's problem data are Views, so every population shares one copy of them
+// On a GPU each population queues its kernels on its own execution space instance, and the generations
+// are stepped in lockstep, so the kernels of small populations that each underuse the device overlap
+template<class Runner>
+class Sweep {
+public:
+  Sweep(Runner& runner, const std::vector<SweepConfig>& configs);
+  auto run(unsigned generations);
+  void set_report_interval(unsigned report_interval);
+  unsigned size() const;
+  const SweepConfig& config(unsigned i) const;
+  // Every population starts with the runner's defaults, which can be changed here before run()
+  Genetic<Runner>& genetic(unsigned i);
+  // Only meaningful after run()
+  double best_rating(unsigned i) const;
+private:
+  void report(unsigned generation);
+
+  std::vector<SweepConfig> configs_;
+  std::vector<Genetic<Runner>> genetics_;
+  std::vector<double> best_ratings_;
+  unsigned report_interval_{100};
+};
+
+template<class Runner>
+Sweep<Runner>::Sweep(Runner& runner, const std::vector<SweepConfig>& configs) :
+  configs_(configs), best_ratings_(configs.size())
+{
+  // Host execution spaces run their kernels one at a time anyway, so they keep every thread
+  std::vector<Kokkos::DefaultExecutionSpace> instances(configs_.size());
+  if constexpr(!std::is_same_v<Kokkos::DefaultExecutionSpace, Kokkos::DefaultHostExecutionSpace>) {
+    if(configs_.size() > 1) {
+      instances = Kokkos::Experimental::partition_space(Kokkos::DefaultExecutionSpace(),
+                                                        std::vector<int>(configs_.size(), 1));
+    }
+  }
+
+  genetics_.reserve(configs_.size());
+  for(unsigned i=0; i<configs_.size(); i++) {
+    genetics_.emplace_back(runner);
+    genetics_[i].set_seed(configs_[i].seed);
+    genetics_[i].set_execution_space(instances[i]);
+  }
+}
+
+template<class Runner>
+void Sweep<Runner>::set_report_interval(unsigned report_interval) {
+  report_interval_ = report_interval;
+}
+
+template<class Runner>
+unsigned Sweep<Runner>::size() const {
+  return configs_.size();
+}
+
+template<class Runner>
+const SweepConfig& Sweep<Runner>::config(unsigned i) const {
+  return configs_[i];
+}
+
+template<class Runner>
+Genetic<Runner>& Sweep<Runner>::genetic(unsigned i) {
+  return genetics_[i];
+}
+
+template<class Runner>
+double Sweep<Runner>::best_rating(unsigned i) const {
+  return best_ratings_[i];
+}
+
+// Returns the best member found by any configuration
+// Every stage is queued for all of the populations before the host waits on any of them
+template<class Runner>
+auto Sweep<Runner>::run(unsigned generations) {
+  unsigned nconfigs = configs_.size();
+  for(unsigned i=0; i<nconfigs; i++) {
+    genetics_[i].initialize(configs_[i].popSize);
+  }
+
+  for(unsigned g=0; g<generations; g++) {
+    for(unsigned i=0; i<nconfigs; i++) {
+      genetics_[i].rank_population(configs_[i].eliteSize);
+    }
+    if(g % report_interval_ == 0) {
+      report(g);
+    }
+    for(unsigned i=0; i<nconfigs; i++) {
+      genetics_[i].next_generation(configs_[i].eliteSize, configs_[i].mutationRate);
+    }
+  }
+
+  for(unsigned i=0; i<nconfigs; i++) {
+    genetics_[i].rank_population(configs_[i].eliteSize);
+  }
+  report(generations);
+
+  unsigned best = 0;
+  for(unsigned i=1; i<nconfigs; i++) {
+    if(best_ratings_[i] > best_ratings_[best]) {
+      best = i;
+    }
+  }
+  return genetics_[best].pull_best();
+}
+
+// Prints the best rating of every configuration
+template<class Runner>
+void Sweep<Runner>::report(unsigned generation) {
+  printf("generation %u:", generation);
+  for(unsigned i=0; i<configs_.size(); i++) {
+    genetics_[i].pull_best();
+    best_ratings_[i] = genetics_[i].best_rating();
+    printf(" %.17g", best_ratings_[i]);
+  }
+  printf("\n");
+}
+
+#endif /* SWEEP_H */
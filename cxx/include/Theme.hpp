@@ -2,6 +2,7 @@
 #define THEME_H
 
 #include "Kokkos_Core.hpp"
+#include "ProblemFile.hpp"
 #include <string>
 #include <unordered_map>
 
@@ -24,6 +25,8 @@ public:
   Similarity compare(const Theme& theme) const;
 
   static void read(const std::string& filename);
+  static void read(ProblemReader& problem);
+  static void save(ProblemWriter& problem);
 
 private:
   unsigned id_;
@@ -2,6 +2,7 @@
 #define TIMESLOTS_H
 
 #include "Kokkos_Core.hpp"
+#include "ProblemFile.hpp"
 
 #include<string>
 #include<vector>
@@ -10,10 +11,13 @@ class Timeslots {
 public:
   Timeslots() = default;
   Timeslots(const std::string& filename);
+  Timeslots(ProblemReader& problem);
   Timeslots(const Timeslots&) = default;
   ~Timeslots() = default;
   Timeslots& operator=(const Timeslots&) = default;
 
+  void save(ProblemWriter& problem) const;
+
   unsigned nlectures(unsigned i) const;
   KOKKOS_FUNCTION unsigned size() const;
 private:
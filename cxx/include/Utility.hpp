@@ -2,6 +2,10 @@
 #define UTILITY_H
 
 #include "Kokkos_Core.hpp"
+#include <cstdint>
+#include <string>
+#include <type_traits>
+#include <vector>
 
 namespace genetic {
 
@@ -45,6 +49,18 @@ bool find(ViewType view, ValType val, unsigned& index) {
   return false;
 }
 
+// Row-major access to a 1D or 2D view through a single index
+template<class ViewType>
+KOKKOS_INLINE_FUNCTION
+decltype(auto) flat(const ViewType& view, unsigned i) {
+  if constexpr(ViewType::rank == 1) {
+    return view(i);
+  }
+  else {
+    return view(i / view.extent(1), i % view.extent(1));
+  }
+}
+
 template<class Scalar>
 KOKKOS_FUNCTION
 void swap(Scalar& s1, Scalar& s2) {
@@ -53,6 +69,318 @@ void swap(Scalar& s1, Scalar& s2) {
   s2 = temp;
 }
 
+// Where row i of the upper triangle of an n by n matrix starts in row-major order
+KOKKOS_INLINE_FUNCTION
+uint64_t triangle_row_start(uint64_t i, uint64_t n) {
+  return i*n - i*(i+1)/2;
+}
+
+// The pair (i,j) with i < j < n at index p of the row-major upper triangle, which has n(n-1)/2 entries
+// The row is found in floating point and then corrected for rounding
+KOKKOS_INLINE_FUNCTION
+Kokkos::pair<unsigned, unsigned> triangle_pair(uint64_t p, unsigned n) {
+  double b = 2.0*n - 1;
+  uint64_t i = (b - Kokkos::sqrt(Kokkos::max(b*b - 8.0*p, 0.0))) / 2;
+  while(i > 0 && triangle_row_start(i, n) > p) i--;
+  while(i+2 < n && triangle_row_start(i+1, n) <= p) i++;
+  return Kokkos::pair<unsigned, unsigned>(i, i + 1 + (p - triangle_row_start(i, n)));
+}
+
+// Compressed sparse row storage for pairwise relations between items
+// Columns within a row must be sorted; entries that aren't stored are zero
+// If no values are provided, every stored entry is one (or true)
+template<class Scalar>
+class CsrMatrix {
+public:
+  CsrMatrix() = default;
+  CsrMatrix(const std::string& label, const std::vector<std::vector<unsigned>>& cols,
+            const std::vector<std::vector<Scalar>>& vals = {});
+  CsrMatrix(Kokkos::View<unsigned*> row_map, Kokkos::View<unsigned*> entries, Kokkos::View<Scalar*> values) :
+    row_map_(row_map), entries_(entries), values_(values) { }
+
+  KOKKOS_INLINE_FUNCTION unsigned nrows() const { return row_map_.extent(0)-1; }
+  KOKKOS_INLINE_FUNCTION unsigned nnz() const { return entries_.extent(0); }
+  KOKKOS_INLINE_FUNCTION unsigned row_begin(unsigned row) const { return row_map_(row); }
+  KOKKOS_INLINE_FUNCTION unsigned row_end(unsigned row) const { return row_map_(row+1); }
+  KOKKOS_INLINE_FUNCTION unsigned degree(unsigned row) const { return row_map_(row+1) - row_map_(row); }
+  KOKKOS_INLINE_FUNCTION unsigned col(unsigned k) const { return entries_(k); }
+  KOKKOS_INLINE_FUNCTION Scalar value(unsigned k) const { return values_.extent(0) > 0 ? values_(k) : Scalar(1); }
+  KOKKOS_INLINE_FUNCTION Scalar operator()(unsigned row, unsigned col) const;
+
+  Kokkos::View<unsigned*> row_map() const { return row_map_; }
+  Kokkos::View<unsigned*> entries() const { return entries_; }
+  Kokkos::View<Scalar*> values() const { return values_; }
+
+private:
+  Kokkos::View<unsigned*> row_map_;
+  Kokkos::View<unsigned*> entries_;
+  Kokkos::View<Scalar*> values_;
+};
+
+template<class Scalar>
+CsrMatrix<Scalar>::CsrMatrix(const std::string& label, const std::vector<std::vector<unsigned>>& cols,
+                             const std::vector<std::vector<Scalar>>& vals)
+{
+  unsigned nrows = cols.size();
+  row_map_ = Kokkos::View<unsigned*>(label + " row map", nrows+1);
+  auto h_row_map = Kokkos::create_mirror_view(row_map_);
+  h_row_map(0) = 0;
+  for(unsigned i=0; i<nrows; i++) {
+    h_row_map(i+1) = h_row_map(i) + cols[i].size();
+  }
+
+  entries_ = Kokkos::View<unsigned*>(label + " entries", h_row_map(nrows));
+  auto h_entries = Kokkos::create_mirror_view(entries_);
+  for(unsigned i=0; i<nrows; i++) {
+    for(unsigned k=0; k<cols[i].size(); k++) {
+      h_entries(h_row_map(i)+k) = cols[i][k];
+    }
+  }
+
+  if(!vals.empty()) {
+    values_ = Kokkos::View<Scalar*>(label + " values", h_row_map(nrows));
+    auto h_values = Kokkos::create_mirror_view(values_);
+    for(unsigned i=0; i<nrows; i++) {
+      for(unsigned k=0; k<vals[i].size(); k++) {
+        h_values(h_row_map(i)+k) = vals[i][k];
+      }
+    }
+    Kokkos::deep_copy(values_, h_values);
+  }
+
+  // Copy the data to device
+  Kokkos::deep_copy(row_map_, h_row_map);
+  Kokkos::deep_copy(entries_, h_entries);
+}
+
+// Binary search of the row for the requested column
+template<class Scalar>
+KOKKOS_INLINE_FUNCTION
+Scalar CsrMatrix<Scalar>::operator()(unsigned row, unsigned col) const {
+  unsigned lo = row_map_(row), hi = row_map_(row+1);
+  while(lo < hi) {
+    unsigned mid = lo + (hi-lo)/2;
+    if(entries_(mid) < col) {
+      lo = mid+1;
+    }
+    else {
+      hi = mid;
+    }
+  }
+  if(lo < row_map_(row+1) && entries_(lo) == col) {
+    return value(lo);
+  }
+  return Scalar(0);
+}
+
+// Dense matrix of flags, packed 64 to a word
+// Set bits are listed per row, like the columns of a CsrMatrix
+class BitMatrix {
+public:
+  BitMatrix() = default;
+  inline BitMatrix(const std::string& label, unsigned ncols, const std::vector<std::vector<unsigned>>& cols);
+  BitMatrix(Kokkos::View<uint64_t**> words, unsigned ncols) : words_(words), ncols_(ncols) { }
+
+  KOKKOS_INLINE_FUNCTION unsigned nrows() const { return words_.extent(0); }
+  KOKKOS_INLINE_FUNCTION unsigned ncols() const { return ncols_; }
+  KOKKOS_INLINE_FUNCTION bool operator()(unsigned row, unsigned col) const {
+    return (words_(row, col/64) >> (col%64)) & 1;
+  }
+
+  Kokkos::View<uint64_t**> words() const { return words_; }
+
+private:
+  Kokkos::View<uint64_t**> words_;
+  unsigned ncols_{0};
+};
+
+BitMatrix::BitMatrix(const std::string& label, unsigned ncols, const std::vector<std::vector<unsigned>>& cols) :
+  words_(label, cols.size(), (ncols+63)/64),
+  ncols_(ncols)
+{
+  auto h_words = Kokkos::create_mirror_view(words_);
+  for(unsigned i=0; i<cols.size(); i++) {
+    for(auto j : cols[i]) {
+      h_words(i, j/64) |= uint64_t(1) << (j%64);
+    }
+  }
+  Kokkos::deep_copy(words_, h_words);
+}
+
+// 64-bit FNV-1a hash of the first n entries of a 1D or 2D view, read through flat()
+template<class ViewType>
+KOKKOS_INLINE_FUNCTION
+uint64_t hash(const ViewType& view, unsigned n) {
+  uint64_t h = 14695981039346656037ull;
+  for(unsigned i=0; i<n; i++) {
+    uint64_t value = flat(view, i);
+    for(unsigned byte=0; byte<sizeof(typename ViewType::value_type); byte++) {
+      h = (h ^ ((value >> (8*byte)) & 0xff)) * 1099511628211ull;
+    }
+  }
+  return h;
+}
+
+// Pseudorandom permutation of [0, n) chosen by key, computed one index at a time
+// A four-round Feistel network permutes the smallest power of four that holds n, and indices it maps
+// past n go through it again until they land inside, which takes fewer than four passes on average
+KOKKOS_INLINE_FUNCTION
+unsigned permute(unsigned index, unsigned n, uint64_t key) {
+  unsigned half_bits = 1;
+  while((uint64_t(1) << (2*half_bits)) < n) half_bits++;
+  uint64_t mask = (uint64_t(1) << half_bits) - 1;
+  do {
+    uint64_t left = index >> half_bits, right = index & mask;
+    for(unsigned round=0; round<4; round++) {
+      // splitmix64 finalizer
+      uint64_t z = key + right + (round + 1) * 0x9e3779b97f4a7c15ull;
+      z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+      z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+      z ^= z >> 31;
+      uint64_t next = left ^ (z & mask);
+      left = right;
+      right = next;
+    }
+    index = unsigned((left << half_bits) | right);
+  } while(index >= n);
+  return index;
+}
+
+// Open-addressing table from 64-bit hashes to the largest index inserted with each hash
+// The capacity is fixed, so it holds at most half as many hashes as it has slots
+class HashIndex {
+public:
+  HashIndex() = default;
+  inline HashIndex(const std::string& label, unsigned capacity);
+
+  template<class ExecSpace>
+  void clear(const ExecSpace& exec) const {
+    Kokkos::deep_copy(exec, keys_, 0);
+    Kokkos::deep_copy(exec, indices_, 0);
+  }
+
+  // Returns the slot holding the hash, whose index() may still grow until every insert is done
+  KOKKOS_INLINE_FUNCTION unsigned insert(uint64_t hash, unsigned index) const {
+    // Zero marks an empty slot
+    if(hash == 0) hash = 1;
+    unsigned mask = keys_.extent(0) - 1;
+    for(unsigned slot = hash & mask; ; slot = (slot+1) & mask) {
+      uint64_t key = Kokkos::atomic_compare_exchange(&keys_(slot), uint64_t(0), hash);
+      if(key == 0 || key == hash) {
+        Kokkos::atomic_max(&indices_(slot), index);
+        return slot;
+      }
+    }
+  }
+
+  KOKKOS_INLINE_FUNCTION unsigned index(unsigned slot) const { return indices_(slot); }
+
+private:
+  Kokkos::View<uint64_t*> keys_;
+  Kokkos::View<unsigned*> indices_;
+};
+
+HashIndex::HashIndex(const std::string& label, unsigned capacity) {
+  unsigned nslots = 1;
+  while(nslots < 2*capacity) nslots *= 2;
+  keys_ = Kokkos::View<uint64_t*>(label + " keys", nslots);
+  indices_ = Kokkos::View<unsigned*>(label + " indices", nslots);
+}
+
+// A schedule with two of its cells swapped, without touching the schedule itself
+// Only the swapped cells can be written, which is all an incremental rating of the swap does
+template<class View2D>
+class SwappedCells {
+public:
+  typedef typename View2D::non_const_value_type value_type;
+
+  KOKKOS_INLINE_FUNCTION SwappedCells(View2D schedule, unsigned cell1, unsigned cell2) :
+    schedule_(schedule), cells_{cell1, cell2}, values_{flat(schedule, cell2), flat(schedule, cell1)} { }
+
+  KOKKOS_INLINE_FUNCTION value_type& operator()(unsigned sl, unsigned r) {
+    unsigned cell = sl*schedule_.extent(1) + r;
+    if(cell == cells_[0]) return values_[0];
+    if(cell == cells_[1]) return values_[1];
+    return schedule_(sl,r);
+  }
+
+  KOKKOS_INLINE_FUNCTION size_t extent(unsigned i) const {
+    return schedule_.extent(i);
+  }
+private:
+  View2D schedule_;
+  unsigned cells_[2];
+  value_type values_[2];
+};
+
+// The positions of the genes of a SwappedCells
+template<class View1D>
+class SwappedPositions {
+public:
+  typedef typename View1D::non_const_value_type value_type;
+
+  KOKKOS_INLINE_FUNCTION SwappedPositions(View1D positions, unsigned gene1, unsigned gene2) :
+    positions_(positions), genes_{gene1, gene2}, cells_{positions(gene2), positions(gene1)} { }
+
+  KOKKOS_INLINE_FUNCTION value_type& operator()(unsigned gene) {
+    if(gene == genes_[0]) return cells_[0];
+    if(gene == genes_[1]) return cells_[1];
+    return positions_(gene);
+  }
+private:
+  View1D positions_;
+  unsigned genes_[2];
+  value_type cells_[2];
+};
+
+// The (cell, old value) pairs of a swap, laid out like the changes Genetic tracks
+template<class Scalar>
+struct SwapChanges {
+  Scalar data[2][2];
+
+  KOKKOS_INLINE_FUNCTION Scalar& operator()(unsigned i, unsigned j) {
+    return data[i][j];
+  }
+};
+
+// Placeholder state for runners that can't update a rating incrementally
+struct NoRatingState { };
+
+// Runners that support incremental rating define a RatingState holding the penalty terms
+template<class Runner, class = void>
+struct rating_state {
+  typedef NoRatingState type;
+  static constexpr bool value = false;
+};
+
+template<class Runner>
+struct rating_state<Runner, std::void_t<typename Runner::RatingState>> {
+  typedef typename Runner::RatingState type;
+  static constexpr bool value = true;
+};
+
+// Runners with their own mutation operators say how many they have
+template<class Runner, class = void>
+struct mutation_operators {
+  static constexpr unsigned value = 0;
+};
+
+template<class Runner>
+struct mutation_operators<Runner, std::void_t<decltype(Runner::nmutation_operators)>> {
+  static constexpr unsigned value = Runner::nmutation_operators;
+};
+
+// Runners with more than one objective say how many they have, and write them from a rating state
+template<class Runner, class = void>
+struct objectives {
+  static constexpr unsigned value = 0;
+};
+
+template<class Runner>
+struct objectives<Runner, std::void_t<decltype(Runner::nobjectives)>> {
+  static constexpr unsigned value = Runner::nobjectives;
+};
+
 } // namespace genetic
 
 #endif /* UTILITY_H */
\ No newline at end of file
@@ -29,38 +29,52 @@ Lectures::Lectures(const std::string& filename) {
 
   // Copy the data to device
   Kokkos::deep_copy(class_codes_, h_codes);
-}
-
-unsigned Lectures::size() const {
-  return class_codes_.extent(0);
-}
 
-unsigned Lectures::topic_cohesion_score(unsigned first, unsigned second) const {
-  unsigned score = 0;
-
-  for(unsigned i=0; i<3; i++) {
-    for(unsigned j=0; j<3; j++) {
-      if(class_codes_(first,i) == class_codes_(second,j)) {
-        score++;
+  // Score every pair of lectures
+  auto class_codes = class_codes_;
+  lecture_scores_ = Kokkos::View<uint8_t**>("lecture-lecture scores", n, n);
+  auto lecture_scores = lecture_scores_;
+  Kokkos::parallel_for("score lectures", n, KOKKOS_LAMBDA(unsigned first) {
+    for(unsigned second=0; second<n; second++) {
+      unsigned score = 0;
+      for(unsigned i=0; i<3; i++) {
+        for(unsigned j=0; j<3; j++) {
+          if(class_codes(first,i) == class_codes(second,j)) {
+            score++;
+          }
+        }
       }
+      lecture_scores(first, second) = score*score;
     }
-  }
-
-  return pow(score,2);
+  });
 }
 
-KOKKOS_FUNCTION unsigned Lectures::topic_cohesion_score(const Minisymposia& mini, unsigned mid, unsigned lid) const {
-  unsigned score = 0;
+unsigned Lectures::size() const {
+  return class_codes_.extent(0);
+}
 
-  for(unsigned i=0; i<3; i++) {
-    for(unsigned j=0; j<3; j++) {
-      if(class_codes_(lid,i) == mini.class_codes(mid,j)) {
-        score++;
+// Scores every lecture against every minisymposium of mini
+void Lectures::set_minisymposia(const Minisymposia& mini) {
+  unsigned nlectures = size();
+  unsigned nmini = mini.size();
+  auto lecture_codes = class_codes_;
+  Kokkos::View<Theme*[3]> mini_codes("minisymposium classification codes", nmini);
+  Kokkos::deep_copy(mini_codes, mini.class_codes());
+  mini_scores_ = Kokkos::View<uint8_t**>("lecture-minisymposium scores", nlectures, nmini);
+  auto mini_scores = mini_scores_;
+  Kokkos::parallel_for("score minisymposia", nlectures, KOKKOS_LAMBDA(unsigned lid) {
+    for(unsigned mid=0; mid<nmini; mid++) {
+      unsigned score = 0;
+      for(unsigned i=0; i<3; i++) {
+        for(unsigned j=0; j<3; j++) {
+          if(lecture_codes(lid,i) == mini_codes(mid,j)) {
+            score++;
+          }
+        }
       }
+      mini_scores(lid, mid) = score*score;
     }
-  }
-
-  return pow(score,2);  
+  });
 }
 
 const std::string& Lectures::title(unsigned index) const {
@@ -75,4 +89,16 @@ Kokkos::View<Theme*[3]>::HostMirror Lectures::class_codes() const {
   auto h_codes = Kokkos::create_mirror_view(class_codes_);
   Kokkos::deep_copy(h_codes, class_codes_);
   return h_codes;
+}
+
+Kokkos::View<uint8_t**>::HostMirror Lectures::lecture_scores() const {
+  auto h_scores = Kokkos::create_mirror_view(lecture_scores_);
+  Kokkos::deep_copy(h_scores, lecture_scores_);
+  return h_scores;
+}
+
+Kokkos::View<uint8_t**>::HostMirror Lectures::mini_scores() const {
+  auto h_scores = Kokkos::create_mirror_view(mini_scores_);
+  Kokkos::deep_copy(h_scores, mini_scores_);
+  return h_scores;
 }
\ No newline at end of file
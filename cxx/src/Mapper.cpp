@@ -1,8 +1,14 @@
 #include "Mapper.hpp"
 #include "Utility.hpp"
+#include <cstdint>
+#include <queue>
+#include <vector>
 
 Mapper::Mapper(const Lectures& lectures, const Minisymposia& minisymposia, unsigned nExtraMini) :
-  lectures_(lectures), minisymposia_(minisymposia), nExtraMini_(nExtraMini) { }
+  lectures_(lectures), minisymposia_(minisymposia), nExtraMini_(nExtraMini)
+{
+  lectures_.set_minisymposia(minisymposia_);
+}
 
 Mapper::ViewType Mapper::make_initial_population(unsigned popSize) {
   // Count the number of lectures in each minisymposium
@@ -15,7 +21,7 @@ Mapper::ViewType Mapper::make_initial_population(unsigned popSize) {
 
   unsigned nlectures = lectures_.size();
   unsigned ngenes = nextra_lect_in_mini + nlect_per_mini_*nExtraMini_;
-  return Kokkos::View<unsigned**>("mappings", popSize, ngenes);
+  return ViewType("mappings", popSize, ngenes);
 }
 
 void Mapper::smush() {
@@ -58,4 +64,205 @@ void Mapper::smush() {
 
 bool Mapper::out_of_bounds(unsigned i) const {
   return i >= lectures_.size();
-}
\ No newline at end of file
+}
+namespace {
+
+// A lecture (or a pair of lectures, for an empty contributed lecture session) for the first open
+// slot of a target, which is a minisymposium or a contributed lecture session
+// version is the first open slot of the target when the candidate was found
+struct Candidate {
+  double score;
+  unsigned target;
+  unsigned version;
+  unsigned lid1;
+  unsigned lid2;
+
+  // The top of the queue is the best score, then the earliest target and lectures
+  bool operator<(const Candidate& c) const {
+    if(score != c.score) return score < c.score;
+    if(target != c.target) return target > c.target;
+    if(lid1 != c.lid1) return lid1 > c.lid1;
+    return lid2 > c.lid2;
+  }
+};
+
+// Deterministic noise in [0,1) that lets the greedy seeds break ties differently
+double tie_breaker(unsigned seed, unsigned a, unsigned b) {
+  if(seed == 0) return 0;
+  uint64_t x = (uint64_t(seed) << 42) ^ (uint64_t(a) << 21) ^ b;
+  x += 0x9e3779b97f4a7c15;
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111eb;
+  x ^= x >> 31;
+  return (x >> 11) * 0x1.0p-53;
+}
+
+}
+
+// Repeatedly puts the best remaining lecture in the first open slot of the best target
+// A candidate is only rescored when it is popped and something it relied on has changed; scores can
+// only go down as lectures are used up, so a stale candidate never beats a fresh one it should lose to
+void Mapper::greedy(Kokkos::View<GeneType**, Kokkos::LayoutStride, Kokkos::HostSpace> solutions) const {
+  using Kokkos::DefaultHostExecutionSpace;
+  using Kokkos::RangePolicy;
+
+  unsigned nlectures = lectures_.size();
+  unsigned nmini = minisymposia_.size();
+  unsigned ngenes = solutions.extent(1);
+  // Lectures scored every lecture against every minisymposium and every other lecture already
+  auto mini_scores = lectures_.mini_scores();
+  auto lecture_scores = lectures_.lecture_scores();
+  RangePolicy<DefaultHostExecutionSpace> lecture_policy(DefaultHostExecutionSpace(), 0, nlectures);
+
+  // The minisymposia come first, then the contributed lecture sessions
+  std::vector<unsigned> target_begin, target_end;
+  unsigned subs = 0;
+  for(unsigned i=0; i<nmini; i++) {
+    target_begin.push_back(subs);
+    subs += nlect_per_mini_ - minisymposia_.nlectures(i);
+    target_end.push_back(subs);
+  }
+  for(; subs+nlect_per_mini_-1<ngenes; subs+=nlect_per_mini_) {
+    target_begin.push_back(subs);
+    target_end.push_back(subs+nlect_per_mini_);
+  }
+  unsigned ntargets = target_begin.size();
+  RangePolicy<DefaultHostExecutionSpace> target_policy(DefaultHostExecutionSpace(), 0, ntargets);
+
+  for(unsigned seed=0; seed<solutions.extent(0); seed++) {
+    auto solution = Kokkos::subview(solutions, seed, Kokkos::ALL());
+    for(unsigned i=0; i<ngenes; i++) {
+      solution(i) = ngenes;
+    }
+    std::vector<unsigned> first_open(target_begin);
+    std::vector<char> used(nlectures, false);
+    unsigned nunused = nlectures;
+
+    // Best score of a lecture in the first open slot of target t, with a bonus for filling a slot at all
+    auto single_score = [&](unsigned t, unsigned lid) {
+      double score;
+      if(t < nmini) {
+        score = mini_scores(lid, t);
+      }
+      else {
+        unsigned nfilled = first_open[t] - target_begin[t];
+        score = 0;
+        for(unsigned k=target_begin[t]; k<first_open[t]; k++) {
+          score += lecture_scores(solution(k), lid);
+        }
+        score /= nfilled;
+      }
+      return score + 1 + tie_breaker(seed, t, lid);
+    };
+    auto pair_score = [&](unsigned lid1, unsigned lid2) {
+      return lecture_scores(lid1, lid2) + tie_breaker(seed, ntargets+lid1, lid2);
+    };
+    auto best_single = [&](unsigned t, Candidate& c) {
+      c = Candidate{-1, t, first_open[t], nlectures, nlectures};
+      for(unsigned lid=0; lid<nlectures; lid++) {
+        if(used[lid]) continue;
+        double score = single_score(t, lid);
+        if(score > c.score) {
+          c.score = score;
+          c.lid1 = lid;
+        }
+      }
+      return c.lid1 < nlectures;
+    };
+    // Pairs are stored with their lower lecture, which partners with a later one
+    auto best_partner = [&](unsigned lid1, Candidate& c) {
+      c = Candidate{-1, 0, 0, lid1, nlectures};
+      for(unsigned lid2=lid1+1; lid2<nlectures; lid2++) {
+        if(used[lid2]) continue;
+        double score = pair_score(lid1, lid2);
+        if(score > c.score) {
+          c.score = score;
+          c.lid2 = lid2;
+        }
+      }
+      return c.lid2 < nlectures;
+    };
+
+    // Every empty contributed lecture session wants the same pair, so they share one queue,
+    // and only the earliest empty session is a target at any time
+    std::vector<Candidate> partners(nlectures);
+    std::vector<char> has_partner(nlectures);
+    Kokkos::parallel_for("find partners", lecture_policy, [&](unsigned lid) {
+      has_partner[lid] = best_partner(lid, partners[lid]);
+    });
+    std::priority_queue<Candidate> pairs;
+    for(unsigned lid=0; lid<nlectures; lid++) {
+      if(has_partner[lid]) pairs.push(partners[lid]);
+    }
+    auto best_pair = [&](unsigned t, Candidate& c) {
+      while(!pairs.empty()) {
+        c = pairs.top();
+        if(!used[c.lid1] && !used[c.lid2]) {
+          c.target = t;
+          c.version = first_open[t];
+          return true;
+        }
+        pairs.pop();
+        if(!used[c.lid1] && best_partner(c.lid1, c)) {
+          pairs.push(c);
+        }
+      }
+      return false;
+    };
+
+    auto is_empty_session = [&](unsigned t) {
+      return t >= nmini && first_open[t] == target_begin[t];
+    };
+    auto find_candidate = [&](unsigned t, Candidate& c) {
+      if(t >= ntargets || first_open[t] == target_end[t] || nunused == 0) return false;
+      if(is_empty_session(t)) return nunused > 1 && best_pair(t, c);
+      return best_single(t, c);
+    };
+
+    // Score the minisymposia and the first contributed lecture session
+    std::vector<Candidate> candidates(ntargets);
+    std::vector<char> has_candidate(ntargets, false);
+    Kokkos::parallel_for("find candidates", target_policy, [&](unsigned t) {
+      if(t < nmini) has_candidate[t] = find_candidate(t, candidates[t]);
+    });
+    if(nmini < ntargets) {
+      has_candidate[nmini] = find_candidate(nmini, candidates[nmini]);
+    }
+    std::priority_queue<Candidate> queue;
+    for(unsigned t=0; t<ntargets; t++) {
+      if(has_candidate[t]) queue.push(candidates[t]);
+    }
+
+    while(!queue.empty() && nunused > 0) {
+      Candidate c = queue.top();
+      queue.pop();
+      unsigned t = c.target;
+      bool is_pair = c.lid2 < nlectures;
+      if(c.version != first_open[t] || used[c.lid1] || (is_pair && used[c.lid2])) {
+        if(find_candidate(t, c)) queue.push(c);
+        continue;
+      }
+
+      // Assign the best option
+      solution(first_open[t]++) = c.lid1;
+      used[c.lid1] = true;
+      nunused--;
+      if(is_pair) {
+        solution(first_open[t]++) = c.lid2;
+        used[c.lid2] = true;
+        nunused--;
+        // The next session is now the earliest empty one
+        if(find_candidate(t+1, c)) queue.push(c);
+      }
+      if(find_candidate(t, c)) queue.push(c);
+    }
+
+    // Fill in the rest
+    for(unsigned i=0, empty_val=nlectures; i < ngenes; i++) {
+      if(solution(i) == ngenes) {
+        solution(i) = empty_val;
+        empty_val++;
+      }
+    }
+  }
+}
@@ -1,5 +1,7 @@
 #include "yaml-cpp/yaml.h"
 #include "Minisymposia.hpp"
+#include <algorithm>
+#include <sstream>
 
 Minisymposia::Minisymposia(const std::string& filename) {
   // Read the minisymposia from yaml on the host
@@ -8,13 +10,11 @@ Minisymposia::Minisymposia(const std::string& filename) {
   unsigned n = nodes.size();
   class_codes_ = Kokkos::View<Theme*[3]>("classification codes", n);
   auto h_codes = Kokkos::create_mirror_view(class_codes_);
-  d_data_ = Kokkos::View<Minisymposium*>("minisymposia", n);
-  h_data_ = Kokkos::create_mirror_view(d_data_);
+  h_data_ = Kokkos::View<Minisymposium*, Kokkos::HostSpace>("minisymposia", n);
 
   unsigned i=0;
   for(auto node : nodes) {
     std::string title = node.first.as<std::string>();
-    std::cout << "Parsing " << title << std::endl;
     unsigned id = node.second["session number"].as<unsigned>();
     std::vector<unsigned> codes = node.second["class codes"].as<std::vector<unsigned>>();
     std::vector<std::string> talks = node.second["talks"].as<std::vector<std::string>>();
@@ -51,7 +51,7 @@ Minisymposia::Minisymposia(const std::string& filename) {
   }
 
   // Copy the data to device
-  Kokkos::deep_copy(d_data_, h_data_);
+  copy_to_device();
   Kokkos::deep_copy(class_codes_, h_codes);
 }
 
@@ -73,14 +73,101 @@ Minisymposia::Minisymposia(const std::string& filename, const Rooms& rooms, cons
   set_priority_penalty_bounds(nslots);
 }
 
-KOKKOS_FUNCTION unsigned Minisymposia::size() const {
-  return d_data_.extent(0);
+Minisymposia::Minisymposia(ProblemReader& problem) :
+  rooms_(problem),
+  timeslots_(problem)
+{
+  Theme::read(problem);
+
+  unsigned n = problem.read<unsigned>();
+  h_data_ = Kokkos::View<Minisymposium*, Kokkos::HostSpace>("minisymposia", n);
+  for(unsigned i=0; i<n; i++) {
+    h_data_(i) = Minisymposium(problem);
+  }
+  copy_to_device();
+  class_codes_ = problem.read_view<Kokkos::View<Theme*[3]>>("classification codes");
+
+  auto read_csr = [&](const std::string& label) {
+    auto row_map = problem.read_view<Kokkos::View<unsigned*>>(label + " row map");
+    auto entries = problem.read_view<Kokkos::View<unsigned*>>(label + " entries");
+    return genetic::CsrMatrix<bool>(row_map, entries, Kokkos::View<bool*>());
+  };
+  same_participants_ = read_csr("overlapping participants");
+  is_prereq_ = read_csr("prerequisites");
+  prereqs_ = read_csr("earlier parts");
+  auto theme_rows = problem.read_view<Kokkos::View<unsigned*>>("theme penalties row map");
+  auto theme_cols = problem.read_view<Kokkos::View<unsigned*>>("theme penalties entries");
+  auto theme_values = problem.read_view<Kokkos::View<double*>>("theme penalties values");
+  theme_penalties_ = genetic::CsrMatrix<double>(theme_rows, theme_cols, theme_values);
+  unsigned nslots = problem.read<unsigned>();
+  valid_timeslots_ = genetic::BitMatrix(problem.read_view<Kokkos::View<uint64_t**>>("valid timeslots"), nslots);
+
+  nprereqs_ = problem.read<unsigned>();
+  max_penalty_ = problem.read<unsigned>();
+  min_priority_penalty_ = problem.read<unsigned>();
+  max_priority_penalty_ = problem.read<unsigned>();
 }
 
-KOKKOS_FUNCTION
-const Minisymposium& Minisymposia::operator[](unsigned i) const {
-  assert(i < size());
-  return d_data_[i];
+Minisymposia Minisymposia::load(const std::string& filename) {
+  ProblemReader problem(filename);
+  return Minisymposia(problem);
+}
+
+Minisymposia Minisymposia::read(const std::string& directory, const std::string& problem_file,
+                                bool save_problem)
+{
+  std::vector<std::string> inputs;
+  for(const char* name : {"codes", "citations", "rooms", "timeslots", "minisymposia"}) {
+    inputs.push_back(directory + "/" + name + ".yaml");
+  }
+  uint64_t key = hash_files(inputs);
+  if(ProblemReader::matches(problem_file, key)) {
+    return load(problem_file);
+  }
+
+  printf("Building %s from the yaml in %s\n", problem_file.c_str(), directory.c_str());
+  Theme::read(inputs[0]);
+  Speaker::read(inputs[1]);
+  Rooms rooms(inputs[2]);
+  Timeslots tslots(inputs[3]);
+  Minisymposia mini(inputs[4], rooms, tslots);
+  if(save_problem) {
+    mini.save(problem_file, key);
+  }
+  return mini;
+}
+
+// The fields are written in the order the problem constructor reads them
+void Minisymposia::save(const std::string& filename, uint64_t key) const {
+  ProblemWriter problem(filename, key);
+  rooms_.save(problem);
+  timeslots_.save(problem);
+  Theme::save(problem);
+
+  problem.write(size());
+  for(unsigned i=0; i<size(); i++) {
+    h_data_(i).save(problem);
+  }
+  problem.write_view(class_codes_);
+
+  for(const auto* csr : {&same_participants_, &is_prereq_, &prereqs_}) {
+    problem.write_view(csr->row_map());
+    problem.write_view(csr->entries());
+  }
+  problem.write_view(theme_penalties_.row_map());
+  problem.write_view(theme_penalties_.entries());
+  problem.write_view(theme_penalties_.values());
+  problem.write(valid_timeslots_.ncols());
+  problem.write_view(valid_timeslots_.words());
+
+  problem.write(nprereqs_);
+  problem.write(max_penalty_);
+  problem.write(min_priority_penalty_);
+  problem.write(max_priority_penalty_);
+}
+
+KOKKOS_FUNCTION unsigned Minisymposia::size() const {
+  return ids_.extent(0);
 }
 
 const Minisymposium& Minisymposia::get(unsigned i) const {
@@ -88,18 +175,38 @@ const Minisymposium& Minisymposia::get(unsigned i) const {
   return h_data_[i];
 }
 
-KOKKOS_FUNCTION
-bool Minisymposia::overlaps_participants(unsigned m1, unsigned m2) const {
-  return same_participants_(m1, m2);
+unsigned Minisymposia::get_max_penalty() const {
+  return max_penalty_;
 }
 
-KOKKOS_FUNCTION
-bool Minisymposia::breaks_ordering(unsigned m1, unsigned m2) const {
-  return is_prereq_(m2, m1);
+std::string Minisymposia::report(const Penalties& penalties) const {
+  std::ostringstream oss;
+
+  oss << "This schedule has score " << score(penalties)
+      << "\nThe penalty for multipart minisymposia being out of order is " << penalties.order
+      << "\nThe penalty for multipart minisymposia not being in consecutive timeslots is " << penalties.gumband_time
+      << "\nThe penalty for multipart minisymposia not being in the same room is " << penalties.gumband_room
+      << "\nThe penalty for putting the same participant in two rooms at once is " << penalties.oversubscribed
+      << "\nThe penalty for putting too many minisymposia with the same themes in the same timeslot is " << penalties.theme
+      << "\nThe penalty for putting a speaker in a timeslot they're not available is " << penalties.timeslot
+      << "\nThe penalty for putting a minisymposium in a room other than what they requested is " << penalties.room
+      << "\nThe penalty for giving a minisymposium too small a room based on estimated popularity is " << penalties.priority
+      << " in [ " << min_priority_penalty_ << ", " << max_priority_penalty_ << "]";
+  return oss.str();
 }
 
-unsigned Minisymposia::get_max_penalty() const {
-  return max_penalty_;
+const char* Minisymposia::term_name(unsigned term) {
+  switch(term) {
+    case ORDER_TERM: return "order";
+    case GUMBAND_TIME_TERM: return "gumband time";
+    case GUMBAND_ROOM_TERM: return "gumband room";
+    case OVERSUBSCRIBED_TERM: return "oversubscribed";
+    case THEME_TERM: return "theme";
+    case TIMESLOT_TERM: return "timeslot";
+    case ROOM_TERM: return "room";
+    case PRIORITY_TERM: return "priority";
+    default: return "unknown";
+  }
 }
 
 void Minisymposia::set_room_penalties(const Rooms& rooms) {
@@ -113,32 +220,39 @@ void Minisymposia::set_room_penalties(const Rooms& rooms) {
   }
 
   // Copy the data to device
-  Kokkos::deep_copy(d_data_, h_data_);
+  copy_to_device();
 
   printf("set_room_penalties max_penalty: %i\n", max_penalty_);
 }
 
+// Each participant lists the minisymposia they are in, and every pair in a list overlaps
 void Minisymposia::set_overlapping_participants() {
-  using Kokkos::parallel_reduce;
-  using Kokkos::DefaultHostExecutionSpace;
-  using Kokkos::RangePolicy;
-
   size_t nmini = size();
-  same_participants_ = Kokkos::View<bool**>("overlapping participants", nmini, nmini);
-  auto h_same_participants = Kokkos::create_mirror_view(same_participants_);
+  std::vector<std::vector<unsigned>> minisymposia_of(Speaker::count());
+  for(unsigned i=0; i<nmini; i++) {
+    for(const auto& participant : h_data_[i].participants()) {
+      if(participant.is_placeholder()) continue;
+      minisymposia_of[participant.id()].push_back(i);
+    }
+  }
 
-  unsigned overlap_penalty = 0;
-  RangePolicy<DefaultHostExecutionSpace> rp(DefaultHostExecutionSpace(), 0, nmini);
-  parallel_reduce("set overlapping participants", rp, [=] (unsigned i, unsigned& lpenalty ) {
-    for(int j=0; j<nmini; j++) {
-      if(i == j) continue;
-      if(h_data_[i].shares_participant(h_data_[j])) {
-        h_same_participants(i,j) = true;
-        lpenalty++;
+  std::vector<std::vector<unsigned>> overlaps(nmini);
+  for(const auto& minis : minisymposia_of) {
+    for(auto m1 : minis) {
+      for(auto m2 : minis) {
+        if(m1 != m2) overlaps[m1].push_back(m2);
       }
     }
-  }, overlap_penalty);
-  Kokkos::deep_copy(same_participants_, h_same_participants);
+  }
+
+  // Minisymposia that share several participants only overlap once
+  unsigned overlap_penalty = 0;
+  for(auto& row : overlaps) {
+    std::sort(row.begin(), row.end());
+    row.erase(std::unique(row.begin(), row.end()), row.end());
+    overlap_penalty += row.size();
+  }
+  same_participants_ = genetic::CsrMatrix<bool>("overlapping participants", overlaps);
   max_penalty_ += overlap_penalty/2;
   printf("set_overlapping_participants max_penalty: %i\n", max_penalty_);
 }
@@ -149,21 +263,29 @@ void Minisymposia::set_prerequisites() {
   using Kokkos::RangePolicy;
 
   size_t nmini = size();
-  is_prereq_ = Kokkos::View<bool**>("prerequisites", nmini, nmini);
-  auto h_is_prereq = Kokkos::create_mirror_view(is_prereq_);
+  std::vector<std::vector<unsigned>> later_parts(nmini);
 
   nprereqs_ = 0;
   RangePolicy<DefaultHostExecutionSpace> rp(DefaultHostExecutionSpace(), 0, nmini);
-  parallel_reduce("set prerequisites", rp, [=] (unsigned i, unsigned& lpenalty ) {
+  parallel_reduce("set prerequisites", rp, [=, &later_parts] (unsigned i, unsigned& lpenalty ) {
     for(int j=0; j<nmini; j++) {
       if(i == j) continue;
       if(h_data_[i].comes_before(h_data_[j])) {
-        h_is_prereq(i,j) = true;
+        later_parts[i].push_back(j);
         lpenalty++;
       }
     }
   }, nprereqs_);
-  Kokkos::deep_copy(is_prereq_, h_is_prereq);
+
+  // Store the transpose too, so we can look up the earlier parts of a minisymposium
+  std::vector<std::vector<unsigned>> earlier_parts(nmini);
+  for(unsigned i=0; i<nmini; i++) {
+    for(auto j : later_parts[i]) {
+      earlier_parts[j].push_back(i);
+    }
+  }
+  is_prereq_ = genetic::CsrMatrix<bool>("prerequisites", later_parts);
+  prereqs_ = genetic::CsrMatrix<bool>("earlier parts", earlier_parts);
   max_penalty_ += nprereqs_; 
   printf("set_prerequisites max_penalty: %i\n", max_penalty_);
 }
@@ -171,21 +293,18 @@ void Minisymposia::set_prerequisites() {
 void Minisymposia::set_valid_timeslots(const Timeslots& slots) {
   size_t nmini = size();
   size_t nslots = slots.size();
-  valid_timeslots_ = Kokkos::View<bool**>("valid timeslots", nmini, nslots);
-  auto h_valid_timeslots_ = Kokkos::create_mirror_view(valid_timeslots_);
+  std::vector<std::vector<unsigned>> valid(nmini);
   for(unsigned i=0; i<nmini; i++) {
-    bool increase_penalty = false;
     for(unsigned j=0; j<nslots; j++) {
-      h_valid_timeslots_(i,j) = h_data_(i).is_valid_timeslot(j) && h_data_(i).size() <= slots.nlectures(j);
-      if(!h_valid_timeslots_(i,j)) {
-        increase_penalty = true;
+      if(h_data_(i).is_valid_timeslot(j) && h_data_(i).size() <= slots.nlectures(j)) {
+        valid[i].push_back(j);
       }
     }
-    if(increase_penalty) {
+    if(valid[i].size() < nslots) {
       max_penalty_++;
     }
   }
-  Kokkos::deep_copy(valid_timeslots_, h_valid_timeslots_);
+  valid_timeslots_ = genetic::BitMatrix("valid timeslots", nslots, valid);
   printf("set_valid_timeslots max_penalty: %i\n", max_penalty_);
 }
 
@@ -201,29 +320,32 @@ void Minisymposia::set_overlapping_themes(unsigned nrooms, unsigned nslots) {
   using Kokkos::RangePolicy;
 
   size_t nmini = size();
-  theme_penalties_ = Kokkos::View<double**>("theme penalties", nmini, nmini);
-  auto h_theme_penalties = Kokkos::create_mirror_view(theme_penalties_);
+  std::vector<std::vector<unsigned>> similar(nmini);
+  std::vector<std::vector<double>> penalties(nmini);
   auto h_class_codes = Kokkos::create_mirror_view(class_codes_);
   Kokkos::deep_copy(h_class_codes, class_codes_);
 
+  // Only minisymposia with related themes are stored
   double total = 0;
   for(unsigned i=0; i<nmini; i++) {
     for(unsigned j=0; j<nmini; j++) {
       if(i == j) continue;
-      h_theme_penalties(i,j) = compute_topic_score(i, j, h_class_codes);
-      total += 2*h_theme_penalties(i,j);
+      unsigned score = compute_topic_score(i, j, h_class_codes);
+      if(score == 0) continue;
+      similar[i].push_back(j);
+      penalties[i].push_back(score);
+      total += 2*score;
     }
   }
 
   // Scale the penalties so the theme penalty will always be in the range [0,0.5]
   for(unsigned i=0; i<nmini; i++) {
-    for(unsigned j=0; j<nmini; j++) {
-      if(i == j) continue;
-      h_theme_penalties(i,j) /= total;
+    for(auto& penalty : penalties[i]) {
+      penalty /= total;
     }
   }
 
-  Kokkos::deep_copy(theme_penalties_, h_theme_penalties);
+  theme_penalties_ = genetic::CsrMatrix<double>("theme penalties", similar, penalties);
 }
 
 void Minisymposia::set_priorities(unsigned nslots) {
@@ -252,7 +374,7 @@ void Minisymposia::set_priorities(unsigned nslots) {
       h_data_[index].set_priority(i);
     }
   }
-  Kokkos::deep_copy(d_data_, h_data_);
+  copy_to_device();
 }
 
 void Minisymposia::set_priority_penalty_bounds(unsigned nslots) {
@@ -296,6 +418,35 @@ void Minisymposia::set_priority_penalty_bounds(unsigned nslots) {
   printf("Priority penalty bounds: %i %i\n", min_priority_penalty_, max_priority_penalty_);
 }
 
+// Rebuilds the device arrays from the host minisymposia
+void Minisymposia::copy_to_device() {
+  unsigned n = h_data_.extent(0);
+  if(ids_.extent(0) != n) {
+    ids_ = Kokkos::View<unsigned*>("minisymposium ids", n);
+    priorities_ = Kokkos::View<unsigned*>("minisymposium priorities", n);
+    room_ids_ = Kokkos::View<unsigned*>("minisymposium room ids", n);
+    nlectures_ = Kokkos::View<unsigned*>("minisymposium sizes", n);
+    is_multipart_ = Kokkos::View<bool*>("minisymposium is multipart", n);
+  }
+  auto h_ids = Kokkos::create_mirror_view(ids_);
+  auto h_priorities = Kokkos::create_mirror_view(priorities_);
+  auto h_room_ids = Kokkos::create_mirror_view(room_ids_);
+  auto h_nlectures = Kokkos::create_mirror_view(nlectures_);
+  auto h_is_multipart = Kokkos::create_mirror_view(is_multipart_);
+  for(unsigned i=0; i<n; i++) {
+    h_ids(i) = h_data_(i).id();
+    h_priorities(i) = h_data_(i).priority();
+    h_room_ids(i) = h_data_(i).room_id();
+    h_nlectures(i) = h_data_(i).size();
+    h_is_multipart(i) = h_data_(i).is_multipart();
+  }
+  Kokkos::deep_copy(ids_, h_ids);
+  Kokkos::deep_copy(priorities_, h_priorities);
+  Kokkos::deep_copy(room_ids_, h_room_ids);
+  Kokkos::deep_copy(nlectures_, h_nlectures);
+  Kokkos::deep_copy(is_multipart_, h_is_multipart);
+}
+
 const Theme& Minisymposia::class_codes(unsigned mid, unsigned cid) const {
   return class_codes_(mid, cid);
 }
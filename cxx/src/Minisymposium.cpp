@@ -56,8 +56,6 @@ Minisymposium::Minisymposium(unsigned id,
     max_citation_count_ = std::max(max_citation_count_, speaker.citations());
   }
 
-  printf("%s: %lf\n", title.c_str(), total_citation_count_);
-
   // Add the participants
   for(const auto& speaker : speakers)
     participants_.push_back(speaker);
@@ -65,7 +63,7 @@ Minisymposium::Minisymposium(unsigned id,
     participants_.push_back(organizer);
   }
 
-  // This needs to be sorted for set_intersection
+  // Sorted by speaker ID, so shares_participant can merge two lists
   std::sort(participants_.begin(), participants_.end());
 
   // Remove duplicates
@@ -73,24 +71,77 @@ Minisymposium::Minisymposium(unsigned id,
   participants_.resize( std::distance(participants_.begin(),it) );
 }
 
+// The citation counts were computed when the problem was saved, so there's no need to read them again
+Minisymposium::Minisymposium(ProblemReader& problem) {
+  title_with_part_ = problem.read_string();
+  title_without_part_ = problem.read_string();
+  room_ = problem.read_string();
+  talks_ = problem.read_vector<std::string>();
+  valid_timeslots_ = problem.read_vector<unsigned>();
+  for(const auto& name : problem.read_vector<std::string>()) {
+    participants_.push_back(Speaker(name));
+  }
+  // The speaker IDs can differ from the run that saved the problem
+  std::sort(participants_.begin(), participants_.end());
+  is_multipart_ = problem.read<bool>();
+  id_ = problem.read<unsigned>();
+  total_citation_count_ = problem.read<unsigned>();
+  max_citation_count_ = problem.read<unsigned>();
+  room_priority_ = problem.read<unsigned>();
+  part_ = problem.read<unsigned>();
+  size_ = problem.read<unsigned>();
+  room_id_ = problem.read<unsigned>();
+}
+
+void Minisymposium::save(ProblemWriter& problem) const {
+  std::vector<std::string> participant_names;
+  for(const auto& participant : participants_) {
+    participant_names.push_back(participant.name());
+  }
+  problem.write(title_with_part_);
+  problem.write(title_without_part_);
+  problem.write(room_);
+  problem.write(talks_);
+  problem.write(valid_timeslots_);
+  problem.write(participant_names);
+  problem.write(is_multipart_);
+  problem.write(id_);
+  problem.write(total_citation_count_);
+  problem.write(max_citation_count_);
+  problem.write(room_priority_);
+  problem.write(part_);
+  problem.write(size_);
+  problem.write(room_id_);
+}
+
+// Both lists of participants are sorted by speaker ID
 bool Minisymposium::shares_participant(const Minisymposium& m) const {
-  std::vector<Speaker> intersection(participants_.size());
-  auto it = std::set_intersection(participants_.begin(), participants_.end(),
-                                  m.participants_.begin(), m.participants_.end(),
-                                  intersection.begin());
-  for(auto i=intersection.begin(); i != it; i++) {
-    if(i->name() != "Presenters to be Announced" && i->name() != "TBD" ) {
-      return true;
+  auto i = participants_.begin();
+  auto j = m.participants_.begin();
+  while(i != participants_.end() && j != m.participants_.end()) {
+    if(*i < *j) {
+      i++;
+    }
+    else if(*j < *i) {
+      j++;
+    }
+    else {
+      if(!i->is_placeholder()) return true;
+      i++;
+      j++;
     }
   }
   return false;
 }
 
+const std::vector<Speaker>& Minisymposium::participants() const {
+  return participants_;
+}
+
 bool Minisymposium::comes_before(const Minisymposium& m) const {
   return title_without_part_ == m.title_without_part_ && part_ < m.part_;
 }
 
-KOKKOS_FUNCTION
 unsigned Minisymposium::priority() const {
   return room_priority_;
 }
@@ -0,0 +1,110 @@
+#include "ProblemFile.hpp"
+#include <cstdio>
+#include <iterator>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Writes to a temporary file that is renamed when the writer goes away,
+// so an interrupted run never leaves a half-written problem behind
+ProblemWriter::ProblemWriter(const std::string& filename, uint64_t key) :
+  filename_(filename),
+  fout_(filename + ".tmp", std::ios::binary)
+{
+  ProblemHeader header{};
+  std::memcpy(header.magic, "PROBLEM", 8);
+  header.version = version_;
+  header.key = key;
+  write(header);
+}
+
+ProblemWriter::~ProblemWriter() {
+  std::string tmp_filename = filename_ + ".tmp";
+  fout_.close();
+  if(!fout_ || std::rename(tmp_filename.c_str(), filename_.c_str()) != 0) {
+    printf("Unable to write problem file %s\n", filename_.c_str());
+  }
+}
+
+void ProblemWriter::write(const std::string& str) {
+  write(uint64_t(str.size()));
+  write_bytes(str.data(), str.size());
+}
+
+void ProblemWriter::write_bytes(const void* data, size_t nbytes) {
+  const char padding[8] = {0};
+  fout_.write(reinterpret_cast<const char*>(data), nbytes);
+  fout_.write(padding, (8 - nbytes % 8) % 8);
+}
+
+ProblemReader::ProblemReader(const std::string& filename) :
+  filename_(filename)
+{
+  int fd = open(filename.c_str(), O_RDONLY);
+  struct stat st;
+  if(fd < 0 || fstat(fd, &st) != 0) {
+    Kokkos::abort("Unable to open the problem file");
+  }
+  size_ = st.st_size;
+  void* data = size_ > 0 ? mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+  close(fd);
+  if(data == MAP_FAILED) {
+    Kokkos::abort("Unable to map the problem file");
+  }
+  data_ = static_cast<const char*>(data);
+
+  ProblemHeader header = read<ProblemHeader>();
+  if(std::memcmp(header.magic, "PROBLEM", 8) != 0 || header.version != ProblemWriter::version_) {
+    Kokkos::abort("Not a problem file, or one written by a different version");
+  }
+}
+
+ProblemReader::~ProblemReader() {
+  munmap(const_cast<char*>(data_), size_);
+}
+
+// Only reads the header, and never aborts, since a missing or stale file just means rebuilding it
+bool ProblemReader::matches(const std::string& filename, uint64_t key) {
+  std::ifstream fin(filename, std::ios::binary);
+  ProblemHeader header;
+  if(!fin.read(reinterpret_cast<char*>(&header), sizeof(header))) {
+    return false;
+  }
+  return std::memcmp(header.magic, "PROBLEM", 8) == 0 && header.version == ProblemWriter::version_ &&
+         header.key == key;
+}
+
+std::string ProblemReader::read_string() {
+  uint64_t n = read<uint64_t>();
+  return std::string(read_bytes(n), n);
+}
+
+const char* ProblemReader::read_bytes(size_t nbytes) {
+  size_t padded = nbytes + (8 - nbytes % 8) % 8;
+  if(offset_ + padded > size_) {
+    Kokkos::abort("The problem file is truncated");
+  }
+  const char* data = data_ + offset_;
+  offset_ += padded;
+  return data;
+}
+
+// The size of each file is hashed too, so moving bytes from one file to the next changes the key
+uint64_t hash_files(const std::vector<std::string>& filenames) {
+  uint64_t hash = 14695981039346656037ull;
+  auto add = [&](const char* data, size_t nbytes) {
+    for(size_t i=0; i<nbytes; i++) {
+      hash ^= static_cast<unsigned char>(data[i]);
+      hash *= 1099511628211ull;
+    }
+  };
+  for(const auto& filename : filenames) {
+    std::ifstream fin(filename, std::ios::binary);
+    std::string contents((std::istreambuf_iterator<char>(fin)), std::istreambuf_iterator<char>());
+    uint64_t nbytes = contents.size();
+    add(reinterpret_cast<const char*>(&nbytes), sizeof(nbytes));
+    add(contents.data(), contents.size());
+  }
+  return hash;
+}
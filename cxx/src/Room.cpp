@@ -11,6 +11,10 @@ const std::string& Room::name() const {
   return name_;
 }
 
+unsigned Room::capacity() const {
+  return capacity_;
+}
+
 bool Room::operator==(const std::string& name) const {
   return name == name_;
 }
\ No newline at end of file
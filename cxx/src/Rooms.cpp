@@ -13,6 +13,27 @@ Rooms::Rooms(const std::string& filename) {
   }
 }
 
+Rooms::Rooms(ProblemReader& problem) {
+  auto names = problem.read_vector<std::string>();
+  auto capacities = problem.read_vector<unsigned>();
+  size_ = names.size();
+  data_.reserve(size_);
+  for(unsigned i=0; i<size_; i++) {
+    data_.push_back(Room(names[i], capacities[i]));
+  }
+}
+
+void Rooms::save(ProblemWriter& problem) const {
+  std::vector<std::string> names;
+  std::vector<unsigned> capacities;
+  for(const auto& room : data_) {
+    names.push_back(room.name());
+    capacities.push_back(room.capacity());
+  }
+  problem.write(names);
+  problem.write(capacities);
+}
+
 unsigned Rooms::size() const {
   return size_;
 }
@@ -8,14 +8,50 @@
 #include <QMessageBox>
 #include <QMimeData>
 #include <QPushButton>
+#include <QStatusBar>
+#include <QtConcurrent>
 
-Schedule::Schedule(Kokkos::View<unsigned**,Kokkos::LayoutStride>::HostMirror mini_indices, const Minisymposia& mini, QObject *parent) : 
+namespace {
+
+// Whether the host can call the rating functions on the problem directly
+constexpr bool host_can_rate = Kokkos::SpaceAccessibility<Kokkos::HostSpace,
+                                                          Kokkos::DefaultExecutionSpace::memory_space>::accessible;
+
+// Rates a schedule from scratch; runs on a worker thread
+Penalties rate_snapshot(Minisymposia mini, Kokkos::View<unsigned**> schedule, Kokkos::View<unsigned*> positions) {
+  Penalties penalties;
+  if constexpr(host_can_rate) {
+    mini.rate_schedule(schedule, positions, penalties);
+  }
+  else {
+    // The whole device cooperates on the one schedule
+    typedef Kokkos::TeamPolicy<>::member_type TeamMember;
+    Kokkos::View<Penalties> d_penalties("penalties");
+    Kokkos::parallel_for("rating schedule", Kokkos::TeamPolicy<>(1, Kokkos::AUTO),
+                         KOKKOS_LAMBDA(const TeamMember& team) {
+      mini.rate_schedule(team, schedule, positions, d_penalties());
+    });
+    Kokkos::deep_copy(penalties, d_penalties);
+  }
+  return penalties;
+}
+
+}
+
+Schedule::Schedule(Kokkos::View<Scheduler::GeneType**,Kokkos::LayoutStride>::HostMirror mini_indices, const Minisymposia& mini, QObject *parent) : 
   d_mini_indices_("minisymposia indices", mini_indices.extent(0), mini_indices.extent(1)), 
-  mini_(mini), QAbstractTableModel(parent)
+  d_positions_("minisymposia positions", mini_indices.extent(0)*mini_indices.extent(1)),
+  d_penalties_("penalties"), mini_(mini), QAbstractTableModel(parent)
 {
+  // The editor keeps its own unsigned copy, since load() marks unfilled cells with unsigned(-1)
   h_mini_indices_ = Kokkos::create_mirror_view(d_mini_indices_);
-  Kokkos::deep_copy(h_mini_indices_, mini_indices);
+  for(unsigned i=0; i<mini_indices.extent(0); i++) {
+    for(unsigned j=0; j<mini_indices.extent(1); j++) {
+      h_mini_indices_(i,j) = mini_indices(i,j);
+    }
+  }
   Kokkos::deep_copy(d_mini_indices_, h_mini_indices_);
+  h_positions_ = Kokkos::create_mirror_view(d_positions_);
 
   // Create a table to display the schedule
   tableView_ = new QTableView();
@@ -76,12 +112,16 @@ Schedule::Schedule(Kokkos::View<unsigned**,Kokkos::LayoutStride>::HostMirror min
   auto searchMenu = window_.menuBar()->addMenu(tr("&Search"));
   searchMenu->addAction(findAct);
 
+  // The score is rated on a worker thread, then kept up to date as the schedule is edited
+  connect(&rescore_, &QFutureWatcher<Penalties>::finished, this, &Schedule::finishRescore);
+  rescore();
+
   // Display the window
   window_.show();
 }
 
 Schedule::~Schedule() {
-
+  rescore_.waitForFinished();
 }
 
 int Schedule::rowCount(const QModelIndex &parent) const {
@@ -126,7 +166,15 @@ QVariant Schedule::headerData(int section, Qt::Orientation orientation, int role
 
 bool Schedule::setData(const QModelIndex &index, const QVariant &value, int role) {
   if(role==Qt::EditRole) {
-    h_mini_indices_(index.column(), index.row()) = value.toInt();
+    // The schedule stays a permutation, so the minisymposium trades places with this cell's
+    unsigned mid = value.toUInt();
+    if(mid >= h_positions_.extent(0))
+      return false;
+    unsigned cell = h_positions_(mid);
+    swapCells(index.column()*h_mini_indices_.extent(1) + index.row(), cell);
+    emit dataChanged(index, index);
+    emit dataChanged(this->index(cell % h_mini_indices_.extent(1), cell / h_mini_indices_.extent(1)),
+                     this->index(cell % h_mini_indices_.extent(1), cell / h_mini_indices_.extent(1)));
     return true;
   }
   return false;
@@ -162,8 +210,10 @@ bool Schedule::dropMimeData(const QMimeData *data, Qt::DropAction action,
   const QModelIndex old_index=index(data->data("row").toInt(),
                                     data->data("col").toInt());
   const QModelIndex current_index=parent;
-  std::swap(h_mini_indices_(old_index.column(), old_index.row()),
-            h_mini_indices_(current_index.column(), current_index.row()));
+  unsigned nrooms = h_mini_indices_.extent(1);
+  swapCells(old_index.column()*nrooms + old_index.row(), current_index.column()*nrooms + current_index.row());
+  emit dataChanged(old_index, old_index);
+  emit dataChanged(current_index, current_index);
   return true;
 }
 
@@ -259,13 +309,126 @@ void Schedule::load() {
         }
       }
     }
+    rescore();
   }
 }
 
 void Schedule::computeScore() {
+  // The score is already up to date unless the worker is still rating the schedule
+  if(!scored_) {
+    showReport_ = true;
+    return;
+  }
+  QMessageBox::information(&window_, tr("Computed Score"), tr(mini_.report(penalties_).c_str()));
+}
+
+// Swaps the minisymposia in two flattened (slot,room) cells and updates the penalties to match
+void Schedule::swapCells(unsigned cell1, unsigned cell2) {
+  using genetic::flat;
+  if(cell1 == cell2)
+    return;
+
+  unsigned gene1 = flat(h_mini_indices_, cell1), gene2 = flat(h_mini_indices_, cell2);
+  flat(h_mini_indices_, cell1) = gene2;
+  flat(h_mini_indices_, cell2) = gene1;
+  h_positions_(gene1) = cell2;
+  h_positions_(gene2) = cell1;
+
+  // The worker's rating doesn't include this edit, so it has to be redone
+  if(!scored_) {
+    stale_ = true;
+    showScore();
+    return;
+  }
+
+  genetic::SwapChanges<unsigned> changes{{{cell1, gene1}, {cell2, gene2}}};
+  if constexpr(host_can_rate) {
+    mini_.update_penalties(h_mini_indices_, h_positions_, changes, 2, penalties_);
+  }
+  else {
+    // One tiny kernel is still much cheaper than rating the whole schedule
+    auto mini = mini_;
+    auto schedule = d_mini_indices_;
+    auto positions = d_positions_;
+    auto penalties = d_penalties_;
+    Kokkos::parallel_for("updating score", 1, KOKKOS_LAMBDA(unsigned) {
+      auto lchanges = changes;
+      flat(schedule, cell1) = gene2;
+      flat(schedule, cell2) = gene1;
+      positions(gene1) = cell2;
+      positions(gene2) = cell1;
+      mini.update_penalties(schedule, positions, lchanges, 2, penalties());
+    });
+    Kokkos::deep_copy(penalties_, d_penalties_);
+  }
+  showScore();
+}
+
+// Rates the whole schedule on a worker thread, which is only needed when it changes wholesale
+void Schedule::rescore() {
+  unsigned nslots = h_mini_indices_.extent(0);
+  unsigned nrooms = h_mini_indices_.extent(1);
+  for(unsigned sl=0; sl<nslots; sl++) {
+    for(unsigned r=0; r<nrooms; r++) {
+      if(h_mini_indices_(sl,r) < h_positions_.extent(0)) {
+        h_positions_(h_mini_indices_(sl,r)) = sl*nrooms + r;
+      }
+    }
+  }
+
+  scored_ = false;
+  if(rescore_.isRunning()) {
+    stale_ = true;
+    showScore();
+    return;
+  }
+  stale_ = false;
+  showScore();
+
+  // The worker gets its own copy, so the schedule can be edited while it runs
+  Kokkos::View<unsigned**> schedule("schedule snapshot", nslots, nrooms);
+  Kokkos::View<unsigned*> positions("positions snapshot", nslots*nrooms);
+  Kokkos::deep_copy(schedule, h_mini_indices_);
+  Kokkos::deep_copy(positions, h_positions_);
+  rescore_.setFuture(QtConcurrent::run(rate_snapshot, mini_, schedule, positions));
+}
+
+void Schedule::finishRescore() {
+  if(stale_) {
+    rescore();
+    return;
+  }
+
+  penalties_ = rescore_.result();
   Kokkos::deep_copy(d_mini_indices_, h_mini_indices_);
-  auto msg = mini_.rate_schedule(d_mini_indices_);
-  QMessageBox::information(&window_, tr("Computed Score"), tr(msg.c_str()));
+  Kokkos::deep_copy(d_positions_, h_positions_);
+  Kokkos::deep_copy(d_penalties_, penalties_);
+  scored_ = true;
+  showScore();
+
+  if(showReport_) {
+    showReport_ = false;
+    computeScore();
+  }
+}
+
+// Shows the score and the hard constraints the schedule breaks in the status bar
+void Schedule::showScore() {
+  if(!scored_) {
+    window_.statusBar()->showMessage(tr("Computing the score..."));
+    return;
+  }
+
+  QString msg = tr("Score %1").arg(mini_.score(penalties_), 0, 'f', 6);
+  if(penalties_.order > 0)
+    msg += tr(" | %1 parts out of order").arg(penalties_.order);
+  if(penalties_.oversubscribed > 0)
+    msg += tr(" | %1 participants in two rooms at once").arg(penalties_.oversubscribed);
+  if(penalties_.timeslot > 0)
+    msg += tr(" | %1 speakers unavailable").arg(penalties_.timeslot);
+  if(penalties_.room > 0)
+    msg += tr(" | %1 room requests not met").arg(penalties_.room);
+  window_.statusBar()->showMessage(msg);
 }
 
 void Schedule::search() {
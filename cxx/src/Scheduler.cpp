@@ -1,12 +1,39 @@
 #include "Scheduler.hpp"
 #include "Utility.hpp"
 #include "Kokkos_StdAlgorithms.hpp"
+#include <algorithm>
 #include <fstream>
+#include <vector>
 
 Scheduler::Scheduler(const Minisymposia& mini) :
   mini_(mini)
 {
-  
+  // Find the first part of every minisymposium and how many parts it has
+  // A head has no earlier parts, and every later part adds one to its count
+  unsigned nmini = mini_.size();
+  auto earlier_map = Kokkos::create_mirror_view_and_copy(Kokkos::HostSpace(), mini_.earlier_parts().row_map());
+  auto later_map = Kokkos::create_mirror_view_and_copy(Kokkos::HostSpace(), mini_.later_parts().row_map());
+  std::vector<unsigned> heads, nparts(nmini);
+  for(unsigned i=0; i<nmini; i++) {
+    nparts[i] = later_map(i+1) - later_map(i) + 1;
+    if(earlier_map(i+1) == earlier_map(i)) heads.push_back(i);
+  }
+
+  // The most constrained minisymposia get first pick: room requests, then the longest, 
+  // then the ones that want the best rooms
+  auto requests_room = [&](unsigned i) { return mini_.get(i).room_id() < nrooms(); };
+  std::stable_sort(heads.begin(), heads.end(), [&](unsigned i, unsigned j) {
+    if(requests_room(i) != requests_room(j)) return requests_room(i);
+    if(nparts[i] != nparts[j]) return nparts[i] > nparts[j];
+    return mini_.get(i).priority() < mini_.get(j).priority();
+  });
+
+  heads_ = Kokkos::View<unsigned*>("greedy order", heads.size());
+  auto h_heads = Kokkos::create_mirror_view(heads_);
+  for(unsigned i=0; i<heads.size(); i++) {
+    h_heads(i) = heads[i];
+  }
+  Kokkos::deep_copy(heads_, h_heads);
 }
 
 Scheduler::ViewType Scheduler::make_initial_population(unsigned nschedules) const {
@@ -26,3 +53,7 @@ KOKKOS_FUNCTION
 unsigned Scheduler::nrooms() const {
   return mini_.rooms().size();
 }
+
+const char* Scheduler::objective_name(unsigned objective) {
+  return Minisymposia::term_name(objective);
+}
@@ -1,34 +1,54 @@
 #include "Speaker.hpp"
 #include "yaml-cpp/yaml.h"
 
-std::unordered_map<std::string, unsigned> Speaker::citation_map_{};
+std::unordered_map<std::string, unsigned> Speaker::id_map_{{"", 0}};
+std::vector<std::string> Speaker::names_{""};
+std::vector<unsigned> Speaker::citations_{0};
 
-Speaker::Speaker(const std::string& name) : name_(name) { 
+Speaker::Speaker(const std::string& name) : id_(intern(name)) { 
   
 }
 
 bool Speaker::operator==(const Speaker& speaker) const {
-  return name_ == speaker.name_;
+  return id_ == speaker.id_;
 }
 
 bool Speaker::operator<(const Speaker& speaker) const {
-  return name_ < speaker.name_;
+  return id_ < speaker.id_;
 }
 
 bool Speaker::empty() const {
-  return name_.empty();
+  return id_ == 0;
+}
+
+bool Speaker::is_placeholder() const {
+  return name() == "Presenters to be Announced" || name() == "TBD";
+}
+
+unsigned Speaker::id() const {
+  return id_;
 }
 
 const std::string& Speaker::name() const {
-  return name_;
+  return names_[id_];
 }
 
 unsigned Speaker::citations() const {
-  // unordered_map.contains is a C++20 feature
-  if(citation_map_.find(name_) != citation_map_.end()) {
-    return citation_map_[name_];
+  return citations_[id_];
+}
+
+unsigned Speaker::count() {
+  return names_.size();
+}
+
+// Returns the ID of name, giving it a new one if it hasn't been seen before
+unsigned Speaker::intern(const std::string& name) {
+  auto [it, inserted] = id_map_.emplace(name, names_.size());
+  if(inserted) {
+    names_.push_back(name);
+    citations_.push_back(0);
   }
-  return 0;
+  return it->second;
 }
 
 void Speaker::read(const std::string& filename) {
@@ -38,6 +58,6 @@ void Speaker::read(const std::string& filename) {
   for(auto node : nodes) {
     std::string name = node.first.as<std::string>();
     unsigned citations = node.second.as<unsigned>();
-    citation_map_[name] = citations;
+    citations_[intern(name)] = citations;
   }
-}
\ No newline at end of file
+}
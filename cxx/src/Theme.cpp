@@ -51,6 +51,25 @@ void Theme::read(const std::string& filename) {
   }
 }
 
+void Theme::read(ProblemReader& problem) {
+  auto ids = problem.read_vector<unsigned>();
+  auto names = problem.read_vector<std::string>();
+  for(unsigned i=0; i<ids.size(); i++) {
+    theme_map_[ids[i]] = names[i];
+  }
+}
+
+void Theme::save(ProblemWriter& problem) {
+  std::vector<unsigned> ids;
+  std::vector<std::string> names;
+  for(const auto& [id, name] : theme_map_) {
+    ids.push_back(id);
+    names.push_back(name);
+  }
+  problem.write(ids);
+  problem.write(names);
+}
+
 std::ostream& operator<<(std::ostream& os, const Theme& theme) {
   os << theme.name();
   return os;
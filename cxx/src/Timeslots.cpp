@@ -13,6 +13,15 @@ Timeslots::Timeslots(const std::string& filename) {
   }
 }
 
+Timeslots::Timeslots(ProblemReader& problem) {
+  nlectures_ = problem.read_vector<unsigned>();
+  size_ = nlectures_.size();
+}
+
+void Timeslots::save(ProblemWriter& problem) const {
+  problem.write(nlectures_);
+}
+
 unsigned Timeslots::nlectures(unsigned i) const {
   return nlectures_[i];
 }
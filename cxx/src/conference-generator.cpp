@@ -0,0 +1,383 @@
+#include "Genetic.hpp"
+#include "Scheduler.hpp"
+#include "yaml-cpp/yaml.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <numeric>
+#include <random>
+#include <sstream>
+#include <sys/resource.h>
+#include <sys/stat.h>
+
+// Writes a synthetic conference in the same yaml schema as the SIAM data, so the scheduler can be
+// tried on problems larger than any real conference
+//
+// usage: conference-generator <output directory> [key=value ...]
+//   minisymposia, rooms, slots, lectures  the size of the conference
+//   talks                                 the most talks in a minisymposium
+//   overlap                               the chance that two minisymposia share a participant
+//   multipart                             the fraction of minisymposia that are part of a series
+//   themes, skew                          the number of theme stems and the Zipf exponent of their popularity
+//   room_requests, restricted             the fraction of minisymposia that ask for a room or for some timeslots
+//   seed
+//   problem                               also save the binary problem to this file
+//   generations, scales, popSize          run the scaling benchmark instead, see run_benchmark
+namespace {
+
+struct ConferenceConfig {
+  unsigned nmini{434};
+  unsigned nrooms{40};
+  unsigned nslots{11};
+  unsigned nlectures{0};
+  unsigned max_talks{5};
+  double overlap{0.01};
+  double multipart{0.6};
+  unsigned nthemes{20};
+  double skew{1.0};
+  double room_requests{0.03};
+  double restricted{0.04};
+  unsigned seed{5374857};
+};
+
+// As in the real data, a series has the same organizers in every part
+constexpr unsigned max_organizers = 3;
+constexpr unsigned subcodes_per_theme = 9;
+
+std::string roman(unsigned i) {
+  static const char* numerals[] = {"I", "II", "III", "IV", "V", "VI", "VII", "VIII", "IX", "X"};
+  return numerals[i-1];
+}
+
+std::string person(unsigned i) {
+  return "Person " + std::to_string(i);
+}
+
+void write_yaml(const std::string& filename, const YAML::Emitter& out) {
+  std::ofstream fout(filename);
+  fout << out.c_str() << "\n";
+}
+
+class ConferenceGenerator {
+public:
+  ConferenceGenerator(const ConferenceConfig& config) :
+    config_(config), rng_(config.seed)
+  {
+    // The themes are popular according to Zipf's law
+    std::vector<double> weights(config_.nthemes);
+    for(unsigned i=0; i<config_.nthemes; i++) {
+      weights[i] = 1.0 / std::pow(i+1, config_.skew);
+    }
+    themes_ = std::discrete_distribution<unsigned>(weights.begin(), weights.end());
+
+    // Each minisymposium has about k participants, drawn uniformly from the people at the conference,
+    // so two of them share nobody with probability (1-k/npeople)^k
+    double k = config_.max_talks + 2;
+    npeople_ = std::max(unsigned(k), unsigned(k / (1 - std::pow(1 - config_.overlap, 1 / k))));
+  }
+
+  void write(const std::string& directory) {
+    mkdir(directory.c_str(), 0755);
+    write_codes(directory + "/codes.yaml");
+    write_citations(directory + "/citations.yaml");
+    write_rooms(directory + "/rooms.yaml");
+    write_timeslots(directory + "/timeslots.yaml");
+    write_minisymposia(directory + "/minisymposia.yaml");
+    if(config_.nlectures > 0) {
+      write_lectures(directory + "/lectures.yaml");
+    }
+  }
+
+private:
+  unsigned stem(unsigned theme) const {
+    return (theme+1)*100;
+  }
+
+  // Two codes share the main theme and the third usually does not
+  std::vector<unsigned> class_codes() {
+    std::uniform_int_distribution<unsigned> subcode(1, subcodes_per_theme);
+    unsigned main_theme = themes_(rng_);
+    return {stem(main_theme) + subcode(rng_), stem(main_theme) + subcode(rng_), stem(themes_(rng_)) + subcode(rng_)};
+  }
+
+  void write_codes(const std::string& filename) {
+    YAML::Emitter out;
+    out << YAML::BeginMap;
+    for(unsigned i=0; i<config_.nthemes; i++) {
+      out << YAML::Key << stem(i) << YAML::Value << "Theme " + std::to_string(i);
+      for(unsigned j=1; j<=subcodes_per_theme; j++) {
+        out << YAML::Key << stem(i)+j << YAML::Value << "Theme " + std::to_string(i) + "." + std::to_string(j);
+      }
+    }
+    out << YAML::EndMap;
+    write_yaml(filename, out);
+  }
+
+  // Citation counts are heavy-tailed
+  void write_citations(const std::string& filename) {
+    std::lognormal_distribution<double> citations(6, 1.5);
+    YAML::Emitter out;
+    out << YAML::BeginMap;
+    for(unsigned i=0; i<npeople_; i++) {
+      out << YAML::Key << person(i) << YAML::Value << unsigned(citations(rng_));
+    }
+    out << YAML::EndMap;
+    write_yaml(filename, out);
+  }
+
+  // Room capacities shrink geometrically from a plenary hall to a seminar room, largest first
+  void write_rooms(const std::string& filename) {
+    YAML::Emitter out;
+    out << YAML::BeginMap;
+    for(unsigned i=0; i<config_.nrooms; i++) {
+      double fraction = config_.nrooms > 1 ? double(i) / (config_.nrooms-1) : 0;
+      out << YAML::Key << "Room " + std::to_string(i) << YAML::Value << unsigned(1750 * std::pow(20.0/1750, fraction));
+    }
+    out << YAML::EndMap;
+    write_yaml(filename, out);
+  }
+
+  void write_timeslots(const std::string& filename) {
+    YAML::Emitter out;
+    out << YAML::BeginMap;
+    for(unsigned i=0; i<config_.nslots; i++) {
+      out << YAML::Key << i+1 << YAML::Value << config_.max_talks;
+    }
+    out << YAML::EndMap;
+    write_yaml(filename, out);
+  }
+
+  void write_minisymposia(const std::string& filename) {
+    // A series has 2 + 0.4/0.6 parts on average, so this many of them make up the multipart fraction
+    double parts_per_series = 2 + 0.4/0.6;
+    double series_fraction = config_.multipart / (config_.multipart + parts_per_series*(1-config_.multipart));
+    std::bernoulli_distribution is_series(series_fraction), requests_room(config_.room_requests),
+                                is_restricted(config_.restricted), is_full(0.8);
+    std::geometric_distribution<unsigned> extra_parts(0.6);
+    std::uniform_int_distribution<unsigned> people(0, npeople_-1), norganizers(1, max_organizers),
+                                            room(0, config_.nrooms-1);
+    unsigned max_parts = std::min(10u, config_.nslots);
+
+    YAML::Emitter out;
+    out << YAML::BeginMap;
+    unsigned series = 0;
+    for(unsigned m=0; m<config_.nmini; series++) {
+      // The parts of a series share their codes and organizers
+      unsigned nparts = 1;
+      if(max_parts > 1 && is_series(rng_)) {
+        nparts = std::min({2 + extra_parts(rng_), max_parts, config_.nmini - m});
+      }
+      std::string title = "Minisymposium " + std::to_string(series);
+      std::vector<unsigned> codes = class_codes();
+      std::vector<std::string> organizers(norganizers(rng_));
+      for(auto& organizer : organizers) {
+        organizer = person(people(rng_));
+      }
+
+      for(unsigned part=1; part<=nparts; part++, m++) {
+        out << YAML::Key << (nparts > 1 ? title + " - Part " + roman(part) + " of " + roman(nparts) : title);
+        out << YAML::Value << YAML::BeginMap;
+        out << YAML::Key << "class codes" << YAML::Value << YAML::Flow << codes;
+        out << YAML::Key << "organizers" << YAML::Value << organizers;
+        out << YAML::Key << "session number" << YAML::Value << m+1;
+
+        unsigned ntalks = is_full(rng_) ? config_.max_talks : std::max(1u, config_.max_talks-1);
+        std::vector<std::string> speakers(ntalks), talks(ntalks);
+        for(unsigned t=0; t<ntalks; t++) {
+          speakers[t] = person(people(rng_));
+          talks[t] = "Talk " + std::to_string(m+1) + "." + std::to_string(t+1);
+        }
+        out << YAML::Key << "speakers" << YAML::Value << speakers;
+        out << YAML::Key << "talks" << YAML::Value << talks;
+
+        if(requests_room(rng_)) {
+          out << YAML::Key << "room" << YAML::Value << "Room " + std::to_string(room(rng_));
+        }
+        // A restricted series could leave no order for its parts, so only single minisymposia are restricted
+        if(nparts == 1 && is_restricted(rng_)) {
+          std::vector<unsigned> slots(config_.nslots);
+          std::iota(slots.begin(), slots.end(), 0);
+          std::shuffle(slots.begin(), slots.end(), rng_);
+          slots.resize(std::max(1u, config_.nslots/2));
+          std::sort(slots.begin(), slots.end());
+          out << YAML::Key << "timeslots" << YAML::Value << YAML::Flow << slots;
+        }
+        out << YAML::EndMap;
+      }
+    }
+    out << YAML::EndMap;
+    write_yaml(filename, out);
+  }
+
+  // The contributed lectures that the mapper groups into extra minisymposia
+  void write_lectures(const std::string& filename) {
+    std::uniform_int_distribution<unsigned> people(0, npeople_-1);
+    YAML::Emitter out;
+    out << YAML::BeginMap;
+    for(unsigned i=0; i<config_.nlectures; i++) {
+      out << YAML::Key << "Lecture " + std::to_string(i) << YAML::Value << YAML::BeginMap;
+      out << YAML::Key << "class codes" << YAML::Value << YAML::Flow << class_codes();
+      out << YAML::Key << "id" << YAML::Value << i;
+      out << YAML::Key << "speaker" << YAML::Value << person(people(rng_));
+      out << YAML::EndMap;
+    }
+    out << YAML::EndMap;
+    write_yaml(filename, out);
+  }
+
+  ConferenceConfig config_;
+  std::mt19937 rng_;
+  std::discrete_distribution<unsigned> themes_;
+  unsigned npeople_;
+};
+
+// The peak resident set size of this process so far
+double peak_memory_mb() {
+  rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_maxrss / 1024.0;
+}
+
+std::vector<unsigned> parse_list(const std::string& str) {
+  std::vector<unsigned> values;
+  std::stringstream ss(str);
+  std::string value;
+  while(std::getline(ss, value, ',')) {
+    values.push_back(std::stoul(value));
+  }
+  return values;
+}
+
+// Generates the conference at each scale, which multiplies the number of minisymposia, rooms and
+// lectures but not the number of timeslots, and times a few generations of the scheduler on it
+// The problem bytes are the size of the saved problem, which is what each copy of the problem costs on
+// the device; the peak memory is the resident set of the whole process, so the scales should increase
+void run_benchmark(const std::string& directory, const ConferenceConfig& config,
+                   const std::vector<unsigned>& scales, unsigned generations, unsigned popSize)
+{
+  printf("scale,nmini,nrooms,nslots,setup seconds,seconds per generation,best rating,problem bytes,peak memory MB\n");
+  for(unsigned scale : scales) {
+    ConferenceConfig scaled = config;
+    scaled.nmini *= scale;
+    scaled.nrooms *= scale;
+    scaled.nlectures *= scale;
+    std::string scale_dir = directory + "/scale-" + std::to_string(scale);
+    ConferenceGenerator(scaled).write(scale_dir);
+
+    Kokkos::Timer timer;
+    std::string problem_file = scale_dir + "/problem";
+    Minisymposia mini = Minisymposia::read(scale_dir, problem_file);
+    double setup_seconds = timer.seconds();
+    std::ifstream problem(problem_file, std::ios::binary | std::ios::ate);
+    size_t problem_bytes = problem.tellg();
+
+    Scheduler s(mini);
+    Genetic<Scheduler> g(s);
+    g.set_delta_rating(true);
+    unsigned eliteSize = popSize / 5;
+    g.initialize(popSize);
+    g.rank_population(eliteSize);
+    Kokkos::fence();
+    timer.reset();
+    for(unsigned i=0; i<generations; i++) {
+      g.next_generation(eliteSize, 0.01);
+      g.rank_population(eliteSize);
+    }
+    Kokkos::fence();
+    double seconds_per_generation = timer.seconds() / generations;
+    g.pull_best();
+
+    printf("%u,%u,%u,%u,%.3e,%.3e,%.17g,%zu,%.1f\n", scale, scaled.nmini, scaled.nrooms, scaled.nslots,
+           setup_seconds, seconds_per_generation, g.best_rating(), problem_bytes, peak_memory_mb());
+    fflush(stdout);
+  }
+}
+
+}
+
+int main(int argc, char* argv[]) {
+  if(argc < 2) {
+    fprintf(stderr, "usage: %s <output directory> [key=value ...]\n", argv[0]);
+    return 1;
+  }
+  std::string directory = argv[1];
+  std::map<std::string, std::string> args;
+  for(int i=2; i<argc; i++) {
+    std::string arg = argv[i];
+    size_t eq = arg.find('=');
+    if(eq == std::string::npos) {
+      fprintf(stderr, "Expected key=value, not %s\n", argv[i]);
+      return 1;
+    }
+    args[arg.substr(0, eq)] = arg.substr(eq+1);
+  }
+  auto get = [&](const std::string& key, auto value) {
+    auto it = args.find(key);
+    if(it == args.end()) {
+      return value;
+    }
+    std::string str = it->second;
+    args.erase(it);
+    if constexpr(std::is_same_v<decltype(value), double>) {
+      return std::stod(str);
+    }
+    else if constexpr(std::is_same_v<decltype(value), unsigned>) {
+      return unsigned(std::stoul(str));
+    }
+    else {
+      return str;
+    }
+  };
+
+  ConferenceConfig config;
+  config.nmini = get("minisymposia", config.nmini);
+  config.nrooms = get("rooms", config.nrooms);
+  config.nslots = get("slots", config.nslots);
+  config.nlectures = get("lectures", config.nlectures);
+  config.max_talks = get("talks", config.max_talks);
+  config.overlap = get("overlap", config.overlap);
+  config.multipart = get("multipart", config.multipart);
+  config.nthemes = get("themes", config.nthemes);
+  config.skew = get("skew", config.skew);
+  config.room_requests = get("room_requests", config.room_requests);
+  config.restricted = get("restricted", config.restricted);
+  config.seed = get("seed", config.seed);
+  std::string problem_file = get("problem", std::string());
+  unsigned generations = get("generations", 0u);
+  std::vector<unsigned> scales = parse_list(get("scales", std::string("1,2,5,10")));
+  unsigned popSize = get("popSize", 1000u);
+  for(const auto& [key, value] : args) {
+    fprintf(stderr, "Unknown option %s\n", key.c_str());
+    return 1;
+  }
+
+  // Every minisymposium needs a cell, and the cells have to fit in a gene with a value to spare for
+  // the greedy seeding's empty marker
+  unsigned max_scale = generations > 0 ? *std::max_element(scales.begin(), scales.end()) : 1;
+  size_t ncells = size_t(config.nrooms) * max_scale * config.nslots;
+  if(config.nmini > config.nrooms * config.nslots ||
+     ncells > std::numeric_limits<Scheduler::GeneType>::max()) {
+    fprintf(stderr, "%u minisymposia do not fit in %u rooms and %u timeslots, or %zu cells do not fit in a gene\n",
+            config.nmini, config.nrooms, config.nslots, ncells);
+    return 1;
+  }
+
+  Kokkos::initialize(argc, argv);
+  {
+    if(generations > 0) {
+      mkdir(directory.c_str(), 0755);
+      run_benchmark(directory, config, scales, generations, popSize);
+    }
+    else {
+      ConferenceGenerator(config).write(directory);
+      if(!problem_file.empty()) {
+        Minisymposia::read(directory, problem_file);
+      }
+    }
+  }
+  Kokkos::finalize();
+  return 0;
+}
@@ -0,0 +1,246 @@
+#include "Genetic.hpp"
+#include "Mapper.hpp"
+#include "Scheduler.hpp"
+#include <benchmark/benchmark.h>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <numeric>
+#include <random>
+
+// Run with --benchmark_format=json (or --benchmark_out=file.json) to track the results between releases
+// The problem comes from GENETIC_BENCH_DATA, which defaults to the SIAM CSE23 data
+namespace {
+
+std::string data_dir() {
+  const char* dir = std::getenv("GENETIC_BENCH_DATA");
+  return dir ? dir : "../../data/SIAM-CSE23";
+}
+
+// The problem is only read once, no matter how many benchmarks use it
+// It holds Views, so main releases it before Kokkos is finalized
+std::unique_ptr<Minisymposia> mini;
+
+const Minisymposia& minisymposia() {
+  if(!mini) {
+    std::string dir = data_dir();
+    Theme::read(dir + "/codes.yaml");
+    Speaker::read(dir + "/citations.yaml");
+    Rooms rooms(dir + "/rooms.yaml");
+    Timeslots tslots(dir + "/timeslots.yaml");
+    mini = std::make_unique<Minisymposia>(dir + "/minisymposia.yaml", rooms, tslots);
+  }
+  return *mini;
+}
+
+// The single-member benchmarks call the rating functions from the host
+constexpr bool host_can_rate = Kokkos::SpaceAccessibility<Kokkos::HostSpace,
+                                                          Kokkos::DefaultExecutionSpace::memory_space>::accessible;
+
+// A random schedule and the positions of its genes
+struct RandomSchedule {
+  Kokkos::View<Scheduler::GeneType**, Kokkos::HostSpace> schedule;
+  Kokkos::View<Scheduler::GeneType*, Kokkos::HostSpace> positions;
+
+  RandomSchedule(const Scheduler& s, unsigned seed) :
+    schedule("schedule", s.nslots(), s.nrooms()),
+    positions("positions", s.nslots()*s.nrooms())
+  {
+    std::vector<unsigned> genes(positions.extent(0));
+    std::iota(genes.begin(), genes.end(), 0);
+    std::shuffle(genes.begin(), genes.end(), std::default_random_engine(seed));
+    for(unsigned cell=0; cell<genes.size(); cell++) {
+      schedule(cell / s.nrooms(), cell % s.nrooms()) = genes[cell];
+      positions(genes[cell]) = cell;
+    }
+  }
+};
+
+void BM_rate_schedule(benchmark::State& state) {
+  if(!host_can_rate) {
+    state.SkipWithError("The problem lives in device memory; see BM_rate_population");
+    return;
+  }
+  const auto& mini = minisymposia();
+  Scheduler s(mini);
+  RandomSchedule r(s, 0);
+  Penalties penalties;
+  for(auto _ : state) {
+    benchmark::DoNotOptimize(mini.rate_schedule(r.schedule, r.positions, penalties));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_rate_schedule);
+
+// Every iteration repairs a fresh copy of the same random schedule
+void BM_fix_order(benchmark::State& state) {
+  if(!host_can_rate) {
+    state.SkipWithError("The problem lives in device memory; see BM_rate_population");
+    return;
+  }
+  Scheduler s(minisymposia());
+  RandomSchedule original(s, 0), r(s, 0);
+  for(auto _ : state) {
+    Kokkos::deep_copy(r.schedule, original.schedule);
+    Kokkos::deep_copy(r.positions, original.positions);
+    s.fix_order(r.schedule, r.positions);
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_fix_order);
+
+// The lecture mapper needs a lectures file, which not every data set has
+void BM_mapper_rate(benchmark::State& state) {
+  std::string dir = data_dir();
+  if(!host_can_rate) {
+    state.SkipWithError("The problem lives in device memory");
+    return;
+  }
+  if(!std::ifstream(dir + "/lectures.yaml")) {
+    state.SkipWithError("No lectures.yaml in the data directory");
+    return;
+  }
+  Theme::read(dir + "/codes.yaml");
+  Lectures lectures(dir + "/lectures.yaml");
+  Minisymposia mini(dir + "/minisymposia.yaml");
+  Mapper m(lectures, mini, state.range(0));
+  auto mappings = Kokkos::create_mirror_view(m.make_initial_population(1));
+  auto mapping = Kokkos::subview(mappings, 0, Kokkos::ALL());
+  std::vector<unsigned> genes(mapping.extent(0));
+  std::iota(genes.begin(), genes.end(), 0);
+  std::shuffle(genes.begin(), genes.end(), std::default_random_engine(0));
+  for(unsigned i=0; i<genes.size(); i++) {
+    mapping(i) = genes[i];
+  }
+  for(auto _ : state) {
+    benchmark::DoNotOptimize(m.rate(mapping));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_mapper_rate)->Arg(0)->Arg(60);
+
+// The population benchmarks take the population size and whether teams share a member
+std::unique_ptr<Genetic<Scheduler>> make_genetic(Scheduler& s, const benchmark::State& state, bool delta_rating) {
+  auto g = std::make_unique<Genetic<Scheduler>>(s);
+  g->set_team_parallelism(state.range(1));
+  g->set_delta_rating(delta_rating);
+  g->initialize(state.range(0));
+  return g;
+}
+
+void population_args(benchmark::internal::Benchmark* b) {
+  b->ArgsProduct({{1000, 10000}, {0, 1}})->ArgNames({"popSize", "team"})->Unit(benchmark::kMillisecond);
+}
+
+// Every member is repaired and rated from scratch
+void BM_rate_population(benchmark::State& state) {
+  Scheduler s(minisymposia());
+  auto g = make_genetic(s, state, false);
+  for(auto _ : state) {
+    g->rate_population();
+    Kokkos::fence();
+  }
+  state.SetItemsProcessed(state.iterations()*state.range(0));
+}
+BENCHMARK(BM_rate_population)->Apply(population_args);
+
+// Every member is repaired, the way it is before being rated from scratch
+// A repaired member is already in order, so each iteration starts from a fresh random population
+void BM_repair_population(benchmark::State& state) {
+  Scheduler s(minisymposia());
+  auto g = make_genetic(s, state, false);
+  for(auto _ : state) {
+    state.PauseTiming();
+    g->initialize(state.range(0));
+    Kokkos::fence();
+    state.ResumeTiming();
+    g->repair_population();
+    Kokkos::fence();
+  }
+  state.SetItemsProcessed(state.iterations()*state.range(0));
+}
+BENCHMARK(BM_repair_population)->Apply(population_args);
+
+// Nothing changes between iterations, so the incremental rating is free and this is all sort
+void BM_sort(benchmark::State& state) {
+  Scheduler s(minisymposia());
+  auto g = make_genetic(s, state, true);
+  unsigned eliteSize = state.range(0) / 5;
+  g->rank_population(eliteSize);
+  for(auto _ : state) {
+    g->rank_population(eliteSize);
+    Kokkos::fence();
+  }
+  state.SetItemsProcessed(state.iterations()*state.range(0));
+}
+BENCHMARK(BM_sort)->Apply(population_args);
+
+// The non-dominated sort compares every pair of members, so it grows much faster than the others
+void BM_pareto_sort(benchmark::State& state) {
+  Scheduler s(minisymposia());
+  auto g = make_genetic(s, state, true);
+  g->set_selection(PARETO_SELECTION);
+  unsigned eliteSize = state.range(0) / 5;
+  g->rank_population(eliteSize);
+  for(auto _ : state) {
+    g->rank_population(eliteSize);
+    Kokkos::fence();
+  }
+  state.SetItemsProcessed(state.iterations()*state.range(0));
+}
+BENCHMARK(BM_pareto_sort)->Apply(population_args);
+
+// Parent selection and crossover for every selection method; get_parent is only reachable through here
+void BM_breed_population(benchmark::State& state) {
+  Scheduler s(minisymposia());
+  auto g = make_genetic(s, state, false);
+  auto selection = static_cast<SelectionMethod>(state.range(2));
+  g->set_selection(selection);
+  unsigned eliteSize = state.range(0) / 5;
+  g->rank_population(eliteSize);
+  for(auto _ : state) {
+    g->compute_weights();
+    if(state.range(1)) {
+      g->breed_population_team(eliteSize);
+    }
+    else {
+      g->breed_population(eliteSize);
+    }
+    Kokkos::fence();
+  }
+  state.SetItemsProcessed(state.iterations()*state.range(0));
+}
+BENCHMARK(BM_breed_population)
+  ->ArgsProduct({{1000, 10000}, {0, 1}, {ROULETTE_SELECTION, TOURNAMENT_SELECTION, UNIVERSAL_SELECTION, PARETO_SELECTION}})
+  ->ArgNames({"popSize", "team", "selection"})->Unit(benchmark::kMillisecond);
+
+// A whole generation the way run() does it
+void BM_generation(benchmark::State& state) {
+  Scheduler s(minisymposia());
+  auto g = make_genetic(s, state, true);
+  unsigned eliteSize = state.range(0) / 5;
+  for(auto _ : state) {
+    g->rank_population(eliteSize);
+    g->next_generation(eliteSize, 0.01);
+    Kokkos::fence();
+  }
+  state.SetItemsProcessed(state.iterations()*state.range(0));
+}
+BENCHMARK(BM_generation)->Apply(population_args);
+
+}
+
+int main(int argc, char* argv[]) {
+  Kokkos::initialize(argc, argv);
+  {
+    benchmark::Initialize(&argc, argv);
+    benchmark::AddCustomContext("kokkos execution space", Kokkos::DefaultExecutionSpace::name());
+    benchmark::AddCustomContext("data", data_dir());
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    mini.reset();
+  }
+  Kokkos::finalize();
+  return 0;
+}
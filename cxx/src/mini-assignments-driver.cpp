@@ -19,6 +19,8 @@ int main(int argc, char* argv[]) {
     // Run the genetic algorithm
     Mapper m(lectures, mini, 0);
     Genetic<Mapper> g(m);
+    // Start from a handful of greedy mappings that break ties differently
+    g.set_greedy_seeds(10);
     auto best_schedule = g.run(1000, 200, 0.01, 100);
     m.record("lecture-assignments", best_schedule);
 
@@ -0,0 +1,47 @@
+#include "Island.hpp"
+#include "Scheduler.hpp"
+#include <iostream>
+
+int main(int argc, char* argv[]) {
+  MPI_Init(&argc, &argv);
+  // Kokkos picks a GPU based on the node-local MPI rank
+  Kokkos::initialize(argc, argv);
+  {
+    int rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+    // Parse the yaml once and save the result, so later runs can load it instead
+    // The problem file is rebuilt whenever any of the yaml changes
+    // Only the first rank builds it; the rest wait for it and load it
+    auto read_problem = [&]() {
+      const std::string directory = "../../data/SIAM-CSE23", problem_file = "SIAM-CSE23.problem";
+      if(rank == 0) {
+        Minisymposia mini = Minisymposia::read(directory, problem_file);
+        MPI_Barrier(MPI_COMM_WORLD);
+        return mini;
+      }
+      MPI_Barrier(MPI_COMM_WORLD);
+      return Minisymposia::read(directory, problem_file, false);
+    };
+    Minisymposia mini = read_problem();
+ 
+    // Run the genetic algorithm on one island per rank
+    Scheduler s(mini);
+    Genetic<Scheduler> g(s);
+    g.set_delta_rating(true);
+    // A single thread per schedule is plenty on the CPU, but not on a GPU
+    g.set_team_parallelism(!std::is_same_v<Kokkos::DefaultExecutionSpace, Kokkos::DefaultHostExecutionSpace>);
+    Island<Scheduler> island(g);
+    island.set_migration(50, 20, RANDOM_TOPOLOGY);
+    Kokkos::Timer timer;
+    timer.reset();
+    auto best_schedule = island.run(10000, 2000, 0.01, 100000);
+    if(rank == 0) {
+      printf("Runtime: %lf seconds\n", timer.seconds());
+      s.record("schedule.md", best_schedule);
+    }
+  }
+  Kokkos::finalize();
+  MPI_Finalize();
+  return 0;
+}
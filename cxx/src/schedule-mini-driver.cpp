@@ -1,4 +1,5 @@
 #include "Genetic.hpp"
+#include "Schedule.hpp"
 #include "Scheduler.hpp"
 #include <iostream>
 #include <QApplication>
@@ -8,24 +9,22 @@ int main(int argc, char* argv[]) {
   QApplication app(argc, argv);
   Kokkos::initialize(argc, argv);
   {
-    // Read the themes from yaml
-    Theme::read("../../data/SIAM-CSE23/codes.yaml");
-
-    // Read the citations from yaml
-    Speaker::read("../../data/SIAM-CSE23/citations.yaml");
-
-    // Read the rooms from yaml
-    Rooms rooms("../../data/SIAM-CSE23/rooms.yaml");
-
-    // Read the timeslots from yaml
-    Timeslots tslots("../../data/SIAM-CSE23/timeslots.yaml");
-
-    // Read the minisymposia from yaml
-    Minisymposia mini("../../data/SIAM-CSE23/minisymposia.yaml", rooms, tslots);
+    // Parse the yaml once and save the result, so later runs can load it instead
+    // The problem file is rebuilt whenever any of the yaml changes
+    Minisymposia mini = Minisymposia::read("../../data/SIAM-CSE23", "SIAM-CSE23.problem");
  
     // Run the genetic algorithm
     Scheduler s(mini);
     Genetic<Scheduler> g(s);
+    g.set_delta_rating(true);
+    // A single thread per schedule is plenty on the CPU, but not on a GPU
+    g.set_team_parallelism(!std::is_same_v<Kokkos::DefaultExecutionSpace, Kokkos::DefaultHostExecutionSpace>);
+    // Resume from the last checkpoint if a previous job was cut short
+    g.set_checkpoint("schedule.ckpt", 10000);
+    g.set_restart("schedule.ckpt");
+    // Raise the mutation rate when the schedule stops improving, and give up if that doesn't help
+    g.set_stagnation_limit(100000);
+    g.set_mutation_escalation(2, 16);
     Kokkos::Timer timer;
     timer.reset();
     auto best_schedule = g.run(10000, 2000, 0.01, 1'000'000'000);
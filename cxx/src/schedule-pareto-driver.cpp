@@ -0,0 +1,68 @@
+#include "Genetic.hpp"
+#include "Scheduler.hpp"
+#include <cstdio>
+
+// Evolves the schedules against every penalty term at once rather than their weighted sum, and writes
+// out one schedule per point of the Pareto front so the organizers can pick the trade-off they like best
+int main(int argc, char* argv[]) {
+  Kokkos::initialize(argc, argv);
+  {
+    // Parse the yaml once and save the result, so later runs can load it instead
+    // The problem file is rebuilt whenever any of the yaml changes
+    Minisymposia mini = Minisymposia::read("../../data/SIAM-CSE23", "SIAM-CSE23.problem");
+
+    Scheduler s(mini);
+    Genetic<Scheduler> g(s);
+    g.set_delta_rating(true);
+    g.set_selection(PARETO_SELECTION);
+    // A single thread per schedule is plenty on the CPU, but not on a GPU
+    g.set_team_parallelism(!std::is_same_v<Kokkos::DefaultExecutionSpace, Kokkos::DefaultHostExecutionSpace>);
+    Kokkos::Timer timer;
+    timer.reset();
+    auto best_schedule = g.run(2000, 400, 0.01, 10000);
+    printf("Runtime: %lf seconds\n", timer.seconds());
+    s.record("schedule.md", best_schedule);
+
+    // Each row is one point on the front with one of the schedules that reach it
+    // Schedules with the same penalties are the same trade-off, so only the first one is written
+    auto objectives = g.pull_objectives();
+    auto fronts = g.pull_fronts();
+    FILE* fout = fopen("pareto.csv", "w");
+    if(!fout) {
+      printf("Unable to write pareto.csv\n");
+    }
+    else {
+      fprintf(fout, "schedule");
+      for(unsigned k=0; k<Scheduler::nobjectives; k++) {
+        fprintf(fout, ",%s", Scheduler::objective_name(k));
+      }
+      fprintf(fout, "\n");
+      std::vector<unsigned> written;
+      for(unsigned i=0; i<fronts.extent(0); i++) {
+        if(fronts(i) != 0) continue;
+        bool repeat = false;
+        for(unsigned j : written) {
+          bool same = true;
+          for(unsigned k=0; k<Scheduler::nobjectives; k++) {
+            same = same && objectives(i,k) == objectives(j,k);
+          }
+          repeat = repeat || same;
+        }
+        if(repeat) continue;
+
+        std::string filename = "pareto-" + std::to_string(written.size()) + ".md";
+        s.record(filename, g.pull_member(i));
+        fprintf(fout, "%s", filename.c_str());
+        for(unsigned k=0; k<Scheduler::nobjectives; k++) {
+          fprintf(fout, ",%.17g", objectives(i,k));
+        }
+        fprintf(fout, "\n");
+        written.push_back(i);
+      }
+      fclose(fout);
+      printf("Wrote %zu points of the Pareto front to pareto.csv\n", written.size());
+    }
+  }
+  Kokkos::finalize();
+  return 0;
+}
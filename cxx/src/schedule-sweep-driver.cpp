@@ -0,0 +1,57 @@
+#include "Scheduler.hpp"
+#include "Sweep.hpp"
+#include "yaml-cpp/yaml.h"
+#include <iostream>
+
+// The configurations come from a yaml list of maps with popSize, eliteSize, mutationRate and an
+// optional seed, or from a small default grid if no file is given
+std::vector<SweepConfig> read_configs(int argc, char* argv[]) {
+  std::vector<SweepConfig> configs;
+  if(argc > 1) {
+    YAML::Node file = YAML::LoadFile(argv[1]);
+    for(auto node : file) {
+      configs.push_back(SweepConfig{node["popSize"].as<unsigned>(), node["eliteSize"].as<unsigned>(),
+                                    node["mutationRate"].as<double>(), node["seed"].as<unsigned>(5374857)});
+    }
+    return configs;
+  }
+
+  unsigned seed = 5374857;
+  for(unsigned popSize : {500, 1000, 2000}) {
+    for(double mutationRate : {0.005, 0.01, 0.02}) {
+      configs.push_back(SweepConfig{popSize, popSize/5, mutationRate, seed++});
+    }
+  }
+  return configs;
+}
+
+int main(int argc, char* argv[]) {
+  Kokkos::initialize(argc, argv);
+  {
+    // Parse the yaml once and save the result, so later runs can load it instead
+    // The problem file is rebuilt whenever any of the yaml changes
+    Minisymposia mini = Minisymposia::read("../../data/SIAM-CSE23", "SIAM-CSE23.problem");
+
+    // Run the genetic algorithm once per configuration, all at the same time
+    Scheduler s(mini);
+    Sweep<Scheduler> sweep(s, read_configs(argc, argv));
+    for(unsigned i=0; i<sweep.size(); i++) {
+      sweep.genetic(i).set_delta_rating(true);
+      // A single thread per schedule is plenty on the CPU, but not on a GPU
+      sweep.genetic(i).set_team_parallelism(!std::is_same_v<Kokkos::DefaultExecutionSpace, Kokkos::DefaultHostExecutionSpace>);
+    }
+    Kokkos::Timer timer;
+    timer.reset();
+    auto best_schedule = sweep.run(10000);
+    printf("Runtime: %lf seconds\n", timer.seconds());
+
+    printf("popSize,eliteSize,mutationRate,seed,rating\n");
+    for(unsigned i=0; i<sweep.size(); i++) {
+      const auto& c = sweep.config(i);
+      printf("%u,%u,%g,%u,%.17g\n", c.popSize, c.eliteSize, c.mutationRate, c.seed, sweep.best_rating(i));
+    }
+    s.record("schedule.md", best_schedule);
+  }
+  Kokkos::finalize();
+  return 0;
+}